@@ -0,0 +1,99 @@
+/**
+ * @file arena.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a bump allocator reset in bulk
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+
+#define ARENA_ALIGN     16
+#define ARENA_ROUND(n)  (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+int arena_init(struct arena* a, size_t size) {
+    a->base = NULL;
+    a->size = 0;
+    a->used = 0;
+    a->spill = NULL;
+    a->peak = 0;
+    
+    if(size == 0)
+        return 0;
+    
+    a->base = malloc(ARENA_ROUND(size));
+    
+    if(a->base == NULL)
+        return -1;
+    
+    a->size = ARENA_ROUND(size);
+    return 0;
+}
+
+void arena_destroy(struct arena* a) {
+    a->peak = 0;
+    arena_reset(a);
+    free(a->base);
+    arena_init(a, 0);
+}
+
+void* arena_alloc(struct arena* a, size_t n) {
+    void* p;
+    struct arena_block* b;
+    
+    n = ARENA_ROUND(n > 0 ? n : 1);
+    a->peak += n;
+    
+    if(a->size - a->used >= n) {
+        p = a->base + a->used;
+        a->used += n;
+        return p;
+    }
+    
+    // overflow: served from the heap until the next reset
+    b = malloc(ARENA_ALIGN + n);
+    
+    if(b == NULL)
+        return NULL;
+    
+    b->next = a->spill;
+    a->spill = b;
+    return (char*)b + ARENA_ALIGN;
+}
+
+/**
+ * @internal
+ *
+ * If the arena spilled since the last reset, the main block is replaced
+ * by one as large as everything requested in the meantime, so the same
+ * request pattern is fully served by the main block from now on.
+ *
+ * @endinternal
+ */
+void arena_reset(struct arena* a) {
+    char* base;
+    struct arena_block* next;
+    
+    if(a->spill != NULL) {
+        while(a->spill != NULL) {
+            next = a->spill->next;
+            free(a->spill);
+            a->spill = next;
+        }
+    
+        base = a->peak > a->size ? malloc(a->peak) : NULL;
+    
+        if(base != NULL) {
+            free(a->base);
+            a->base = base;
+            a->size = a->peak;
+        }
+    }
+    
+    a->used = 0;
+    a->peak = 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file arena.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the interface of a bump allocator reset in bulk
+ *
+ * This file contains the interface of an arena: allocations are carved
+ * sequentially out of a block and are never freed one by one, the
+ * whole arena is reset at once when its owner is done with them. When
+ * the block is exhausted the arena spills into extra blocks and, at the
+ * next reset, replaces its block with one large enough for the whole
+ * high-water mark, so a steady workload stops touching the heap after
+ * the first few resets. The arena is not thread-safe.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// ---------------------------------------------
+// DATA STRUCTURES
+// ---------------------------------------------
+
+/**
+ * @brief Represent a block spilled out of the arena
+ */
+struct arena_block {
+    struct arena_block*     next;   /** contains the next spilled block */
+};
+
+/**
+ * @brief Represent the arena object
+ *
+ * The structure contains the main block, its size and the bytes used
+ * from it, the spilled blocks and the bytes requested since the last
+ * reset.
+ */
+struct arena {
+    char*                   base;   /** contains the main block */
+    size_t                  size;   /** contains the size of the main block */
+    size_t                  used;   /** contains the bytes used from the main block */
+    struct arena_block*     spill;  /** contains the blocks allocated on overflow */
+    size_t                  peak;   /** contains the bytes requested since the last reset */
+};
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+/**
+ * @brief Initialize the arena in order to be used
+ *
+ * @param a pointer to the arena to be initialized
+ * @param size initial size of the main block, 0 to allocate it lazily
+ * @return -1 in case of error, 0 otherwise
+ */
+int arena_init(struct arena* a, size_t size);
+
+/**
+ * @brief Release all the memory of the arena
+ *
+ * @param a pointer to the arena
+ */
+void arena_destroy(struct arena* a);
+
+/**
+ * @brief Carve an allocation out of the arena
+ *
+ * The memory is aligned for any type and is valid until the next
+ * reset of the arena.
+ *
+ * @param a pointer to the arena
+ * @param n number of bytes
+ * @return the memory, NULL if the heap is exhausted
+ */
+void* arena_alloc(struct arena* a, size_t n);
+
+/**
+ * @brief Invalidate all the allocations of the arena at once
+ *
+ * @param a pointer to the arena
+ */
+void arena_reset(struct arena* a);
+
+#endif
@@ -2,15 +2,15 @@
  * @file atomic.h
  * @author Gabriele Serra
  * @date 21 Nov 2018
- * @brief Defines a pseudo-atomic type on x64 architectures 
+ * @brief Defines an atomic type on x64 architectures 
  *
- * This file contains the definition of a pseudo-atomic type
- * on x64 architectures. The atomicity is realized with the 
- * volatile keyword. It need the version of GCC greater than 4
- * because it contains some inline methods to work with the atomic
- * type. Note that atomicity on CPU that are not Intel is guaranteed
- * only for the LS 24 bits.
- * Read more: https://gcc.gnu.org/onlinedocs/gcc-4.1.0/gcc/Atomic-Builtins.html
+ * This file contains the definition of an atomic type on x64
+ * architectures. Plain reads and writes are relaxed atomic accesses
+ * and the other operations follow the C11 memory model, through the
+ * GCC __atomic builtins, so the type can be shared with another process
+ * in a memory segment. It also provides sequence counters, used to
+ * publish a group of values that readers must see as a whole.
+ * Read more: https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html
  */
 
 #ifndef _ATOMIC_H
@@ -44,21 +44,43 @@ typedef struct {
 /**
  * @brief Read atomic variable
  * 
- * Atomically reads the the value of @v
+ * Atomically reads the the value of @v. No ordering is implied.
  * 
  * @param v pointer of type atomic_t
  */
-#define atomic_read(v) ((v)->counter)
+#define atomic_read(v) __atomic_load_n(&((v)->counter), __ATOMIC_RELAXED)
 
 /**
  * @brief Set atomic variable
  * 
- * Copy the value @i into the variable @v
+ * Atomically copy the value @i into the variable @v. No ordering
+ * is implied.
  * 
  * @param v pointer of type atomic_t
  * @param i required value
  */
-#define atomic_set(v,i) (((v)->counter) = (i))
+#define atomic_set(v,i) __atomic_store_n(&((v)->counter), (i), __ATOMIC_RELAXED)
+
+/**
+ * @brief Read atomic variable with acquire semantic
+ * 
+ * Atomically reads the value of @v. Memory accesses that follow
+ * in program order can not be moved before the read.
+ * 
+ * @param v pointer of type atomic_t
+ */
+#define atomic_read_acquire(v) __atomic_load_n(&((v)->counter), __ATOMIC_ACQUIRE)
+
+/**
+ * @brief Set atomic variable with release semantic
+ * 
+ * Copy the value @i into the variable @v. Memory accesses that
+ * precede in program order are visible before the new value.
+ * 
+ * @param v pointer of type atomic_t
+ * @param i required value
+ */
+#define atomic_set_release(v,i) __atomic_store_n(&((v)->counter), (i), __ATOMIC_RELEASE)
 
 /**
  * @brief Add to the atomic variable
@@ -152,4 +174,52 @@ static inline int atomic_inc_and_test(atomic_t *v) {
 	return !(__sync_add_and_fetch(&v->counter, 1));
 }
 
+/**
+ * @brief Open the write section of a sequence counter
+ *
+ * The counter stays odd until atomic_seq_write_end. The values written
+ * in between with atomic_set are seen by the readers all together or
+ * not at all. Writers of the same counter must not overlap.
+ *
+ * @param seq pointer to the sequence counter
+ */
+static inline void atomic_seq_write_begin(atomic_t* seq) {
+	atomic_set(seq, atomic_read(seq) + 1);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Close the write section of a sequence counter
+ *
+ * @param seq pointer to the sequence counter
+ */
+static inline void atomic_seq_write_end(atomic_t* seq) {
+	atomic_set_release(seq, atomic_read(seq) + 1);
+}
+
+/**
+ * @brief Start reading values guarded by a sequence counter
+ *
+ * @param seq pointer to the sequence counter
+ * @return the value to be passed to atomic_seq_read_retry
+ */
+static inline uint64_t atomic_seq_read_begin(atomic_t* seq) {
+	return atomic_read_acquire(seq);
+}
+
+/**
+ * @brief Check if the values read since atomic_seq_read_begin are torn
+ *
+ * The values read with atomic_read since @start are consistent if the
+ * function returns 0, otherwise they must be read again.
+ *
+ * @param seq pointer to the sequence counter
+ * @param start value returned by atomic_seq_read_begin
+ * @return 1 if a writer was active meanwhile, 0 otherwise
+ */
+static inline int atomic_seq_read_retry(atomic_t* seq, uint64_t start) {
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return (start & 1) || atomic_read(seq) != start;
+}
+
 #endif
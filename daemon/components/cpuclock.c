@@ -0,0 +1,70 @@
+/**
+ * @file cpuclock.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a thread cpu time clock read without system calls
+ */
+
+#define _GNU_SOURCE
+
+#include "cpuclock.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// ---------------------------------------------
+// PUBLIC METHODS
+// ---------------------------------------------
+
+int cpuclock_open(struct cpuclock* c) {
+#ifdef __x86_64__
+    struct perf_event_attr attr;
+    uint64_t ns;
+    
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.pinned = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    
+    c->page = NULL;
+    c->fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    
+    if(c->fd < 0)
+        return -1;
+    
+    c->page = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, c->fd, 0);
+    
+    if(c->page == MAP_FAILED) {
+        c->page = NULL;
+        cpuclock_close(c);
+        return -1;
+    }
+    
+    // without the scale the time stops at the last switch
+    if(!c->page->cap_user_time || cpuclock_read(c, &ns) < 0) {
+        cpuclock_close(c);
+        return -1;
+    }
+    
+    return 0;
+#else
+    c->fd = -1;
+    c->page = NULL;
+    return -1;
+#endif
+}
+
+void cpuclock_close(struct cpuclock* c) {
+    if(c->page != NULL)
+        munmap(c->page, sysconf(_SC_PAGESIZE));
+    
+    if(c->fd >= 0)
+        close(c->fd);
+    
+    c->page = NULL;
+    c->fd = -1;
+}
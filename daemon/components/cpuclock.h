@@ -0,0 +1,97 @@
+/**
+ * @file cpuclock.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Cpu time of the calling thread read without system calls
+ *
+ * This file contains the interface of cpuclock component. It opens a
+ * self-monitoring perf_event counter on the calling thread and maps its
+ * control page: the kernel keeps there the time the counter, hence the
+ * thread, ran on a cpu up to its last switch, and the scale to extend it
+ * to now from the time stamp counter. Reading it takes no system call,
+ * while preemptions are left out as in CLOCK_THREAD_CPUTIME_ID. It is only
+ * available where the processor has a counter the thread may open and the
+ * kernel exports the time scale.
+ */
+
+#ifndef CPUCLOCK_H
+#define CPUCLOCK_H
+
+#include <stdint.h>
+#include <linux/perf_event.h>
+
+#ifdef __x86_64__
+    #include <x86intrin.h>
+#endif
+
+/**
+ * @brief Represent the cpuclock object
+ */
+struct cpuclock {
+    int                             fd;     /** the counter, -1 if closed */
+    struct perf_event_mmap_page*    page;   /** its control page */
+};
+
+/**
+ * @brief Open the clock of the calling thread
+ *
+ * The counter is pinned, so that it is never multiplexed out while the
+ * thread runs, and counts user cycles only, which unprivileged threads
+ * may do. The clock must be read by the thread that opened it.
+ *
+ * @param c pointer to cpuclock struct to be opened
+ * @return -1 if the counter or the time scale are missing, 0 otherwise
+ */
+int cpuclock_open(struct cpuclock* c);
+
+/**
+ * @brief Close the clock
+ *
+ * @param c pointer to an open cpuclock struct
+ */
+void cpuclock_close(struct cpuclock* c);
+
+/**
+ * @brief Read the clock
+ *
+ * The control page is read under its sequence counter. The counter is
+ * on the cpu whenever the thread runs, unless the kernel took it away
+ * for good (e.g. for a pinned event of higher priority).
+ *
+ * @param c pointer to a cpuclock struct opened by the calling thread
+ * @param ns the cpu time of the thread since the clock was opened [ns]
+ * @return -1 if the counter is not on the cpu, 0 otherwise
+ */
+static inline int cpuclock_read(const struct cpuclock* c, uint64_t* ns) {
+#ifdef __x86_64__
+    volatile struct perf_event_mmap_page* pc = c->page;
+    uint32_t seq, idx;
+    uint64_t running, cyc, quot, rem;
+    
+    do {
+        seq = pc->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        
+        idx = pc->index;
+        running = pc->time_running;
+        cyc = __rdtsc();
+        quot = cyc >> pc->time_shift;
+        rem = cyc & (((uint64_t)1 << pc->time_shift) - 1);
+        running += pc->time_offset + quot * pc->time_mult + ((rem * pc->time_mult) >> pc->time_shift);
+        
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while(pc->lock != seq);
+    
+    if(idx == 0)
+        return -1;
+    
+    *ns = running;
+    return 0;
+#else
+    (void)c;
+    (void)ns;
+    return -1;
+#endif
+}
+
+#endif
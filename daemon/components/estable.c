@@ -0,0 +1,172 @@
+/**
+ * @file estable.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a table of estimator slots in shared memory
+ */
+
+#define _GNU_SOURCE
+
+#include "estable.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ESTABLE_ROUND(n)    (((n) + ESTABLE_CACHE_LINE - 1) & ~(size_t)(ESTABLE_CACHE_LINE - 1))
+#define ESTABLE_SEALS       (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)
+
+// ---------------------------------------------
+// PRIVATE METHODS
+// ---------------------------------------------
+
+static size_t estable_hdr_size() {
+    return ESTABLE_ROUND(sizeof(struct estable_hdr));
+}
+
+static int estable_map(struct estable* t, int fd, size_t len) {
+    void* addr;
+    
+    addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    
+    if(addr == MAP_FAILED)
+        return -1;
+    
+    t->fd = fd;
+    t->len = len;
+    t->hdr = addr;
+    t->data = (char*)addr + estable_hdr_size();
+    t->free = NULL;
+    t->nfree = 0;
+    return 0;
+}
+
+// ---------------------------------------------
+// PUBLIC METHODS
+// ---------------------------------------------
+
+/**
+ * @internal
+ *
+ * Free slots are kept in a stack, lowest index on top: the slot just
+ * given back is the first handed out again, while its lines are still
+ * warm, and the table is used from its beginning.
+ *
+ * @endinternal
+ */
+int estable_create(struct estable* t, uint32_t nslot, uint32_t nvalue) {
+    int fd;
+    size_t len;
+    uint32_t slot_size;
+    
+    if(nslot == 0 || nvalue == 0)
+        return -1;
+    
+    slot_size = ESTABLE_ROUND(nvalue * sizeof(atomic_t));
+    len = estable_hdr_size() + (size_t)nslot * slot_size;
+    fd = memfd_create("estable", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    
+    if(fd < 0)
+        return -1;
+    
+    if(ftruncate(fd, len) < 0 || fcntl(fd, F_ADD_SEALS, ESTABLE_SEALS) < 0 || estable_map(t, fd, len) < 0) {
+        close(fd);
+        return -1;
+    }
+    
+    t->free = malloc(nslot * sizeof(uint32_t));
+    
+    if(t->free == NULL) {
+        estable_close(t);
+        return -1;
+    }
+    
+    for(uint32_t i = 0; i < nslot; i++)
+        t->free[i] = nslot - 1 - i;
+    
+    t->nfree = nslot;
+    t->nslot = nslot;
+    t->nvalue = nvalue;
+    t->slot_size = slot_size;
+    t->hdr->nslot = nslot;
+    t->hdr->nvalue = nvalue;
+    t->hdr->slot_size = slot_size;
+    t->hdr->magic = ESTABLE_MAGIC;
+    return 0;
+}
+
+/**
+ * @internal
+ *
+ * The geometry is copied out of the header once checked: the creator
+ * may still scribble on the header, the slots are never looked up
+ * through it.
+ *
+ * @endinternal
+ */
+int estable_open(struct estable* t, int fd, uint32_t nvalue) {
+    int seals;
+    struct stat st;
+    struct estable_hdr hdr;
+    
+    seals = fcntl(fd, F_GET_SEALS);
+    
+    if(seals < 0 || (seals & ESTABLE_SEALS) != ESTABLE_SEALS)
+        return -1;
+    
+    if(fstat(fd, &st) < 0 || st.st_size < (off_t)estable_hdr_size())
+        return -1;
+    
+    if(estable_map(t, fd, st.st_size) < 0)
+        return -1;
+    
+    memcpy(&hdr, t->hdr, sizeof(struct estable_hdr));
+    
+    if(hdr.magic != ESTABLE_MAGIC || hdr.nvalue < nvalue || hdr.slot_size % ESTABLE_CACHE_LINE != 0 ||
+       hdr.slot_size < hdr.nvalue * sizeof(atomic_t) ||
+       estable_hdr_size() + (size_t)hdr.nslot * hdr.slot_size > t->len) {
+        munmap(t->hdr, t->len);
+        return -1;
+    }
+    
+    t->nslot = hdr.nslot;
+    t->nvalue = hdr.nvalue;
+    t->slot_size = hdr.slot_size;
+    return 0;
+}
+
+void estable_close(struct estable* t) {
+    free(t->free);
+    munmap(t->hdr, t->len);
+    close(t->fd);
+    t->free = NULL;
+    t->nfree = 0;
+}
+
+int estable_alloc(struct estable* t) {
+    uint32_t slot;
+    
+    if(t->nfree == 0)
+        return -1;
+    
+    slot = t->free[--t->nfree];
+    memset(t->data + (size_t)slot * t->slot_size, 0, t->slot_size);
+    return slot;
+}
+
+void estable_free(struct estable* t, uint32_t slot) {
+    // the free list never holds more than the slots, even if one is freed twice
+    if(t->free == NULL || slot >= t->nslot || t->nfree >= t->nslot)
+        return;
+    
+    t->free[t->nfree++] = slot;
+}
+
+atomic_t* estable_slot(struct estable* t, uint32_t slot) {
+    if(slot >= t->nslot)
+        return NULL;
+    
+    return (atomic_t*)(t->data + (size_t)slot * t->slot_size);
+}
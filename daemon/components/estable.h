@@ -0,0 +1,123 @@
+/**
+ * @file estable.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Table of estimator slots in shared memory
+ *
+ * This file contains the interface of estable component. It realizes
+ * a table of fixed-size slots of atomic values, backed by an anonymous
+ * memory file (memfd) that the creator hands to another process. Each
+ * slot starts on its own cache line, so the writers of two slots never
+ * share a line. The creator hands slots out and takes them back; the
+ * other process only maps the table and reads or writes the slots it
+ * has been told about. The size of the file is sealed at creation, so
+ * the creator can not shrink the table under the feet of the others.
+ */
+
+#ifndef ESTABLE_H
+#define ESTABLE_H
+
+#include "atomic.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Alignment of the header and of each slot
+ */
+#define ESTABLE_CACHE_LINE 64
+
+/**
+ * @brief Value placed at the beginning of each table
+ */
+#define ESTABLE_MAGIC 0x45535442
+
+/**
+ * @brief Header placed at the beginning of the shared segment
+ */
+struct estable_hdr {
+    uint32_t    magic;      /** ESTABLE_MAGIC */
+    uint32_t    nslot;      /** Number of slots */
+    uint32_t    nvalue;     /** Number of values in each slot */
+    uint32_t    slot_size;  /** Distance between two slots, multiple of a cache line */
+};
+
+/**
+ * @brief Represent the estable object
+ *
+ * Local view of the table: the memory file descriptor, the length of
+ * the mapping, the geometry validated when the table was created or
+ * opened and, on the creator side only, the list of free slots.
+ */
+struct estable {
+    int                 fd;         /** Memory file descriptor */
+    size_t              len;        /** Length of the mapping */
+    struct estable_hdr* hdr;        /** Pointer to the shared header */
+    char*               data;       /** Pointer to the first slot */
+    uint32_t            nslot;      /** Number of slots */
+    uint32_t            nvalue;     /** Number of values in each slot */
+    uint32_t            slot_size;  /** Distance between two slots */
+    uint32_t*           free;       /** Free slots, NULL if not the creator */
+    uint32_t            nfree;      /** Number of free slots */
+};
+
+/**
+ * @brief Create a new table
+ *
+ * Allocate a memory file large enough for @nslot slots of @nvalue
+ * values each, seal its size and map it. All the slots are free.
+ *
+ * @param t pointer to estable struct to be created
+ * @param nslot number of slots
+ * @param nvalue number of values in each slot
+ * @return -1 in case of error, 0 otherwise
+ */
+int estable_create(struct estable* t, uint32_t nslot, uint32_t nvalue);
+
+/**
+ * @brief Map a table created by another process
+ *
+ * Map the memory file @fd received from the creator of the table. The
+ * table is refused if its size is not sealed, if it is smaller than its
+ * header claims or if its slots hold less than @nvalue values. The
+ * estable takes ownership of the descriptor only on success.
+ *
+ * @param t pointer to estable struct
+ * @param fd memory file descriptor of the table
+ * @param nvalue minimum number of values in each slot
+ * @return -1 in case of error, 0 otherwise
+ */
+int estable_open(struct estable* t, int fd, uint32_t nvalue);
+
+/**
+ * @brief Unmap the table and close its descriptor
+ *
+ * @param t pointer to estable struct
+ */
+void estable_close(struct estable* t);
+
+/**
+ * @brief Take a free slot, cleared (creator side)
+ *
+ * @param t pointer to estable struct
+ * @return the index of the slot, -1 if the table is full
+ */
+int estable_alloc(struct estable* t);
+
+/**
+ * @brief Give a slot back to the table (creator side)
+ *
+ * @param t pointer to estable struct
+ * @param slot index of a slot obtained from estable_alloc
+ */
+void estable_free(struct estable* t, uint32_t slot);
+
+/**
+ * @brief Get the values of a slot
+ *
+ * @param t pointer to estable struct
+ * @param slot index of the slot
+ * @return pointer to the first value of the slot, NULL if out of the table
+ */
+atomic_t* estable_slot(struct estable* t, uint32_t slot);
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file jqueue.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a thread-safe FIFO queue of jobs
+ */
+
+#include "jqueue.h"
+#include <stddef.h>
+
+// ---------------------------------------------
+// PRIVATE METHODS
+// ---------------------------------------------
+
+static struct jqueue_node* jqueue_unlink(struct jqueue* q) {
+    struct jqueue_node* n = q->head;
+    
+    if(n == NULL)
+        return NULL;
+    
+    q->head = n->next;
+    
+    if(q->head == NULL)
+        q->tail = NULL;
+    
+    n->next = NULL;
+    return n;
+}
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+int jqueue_init(struct jqueue* q) {
+    q->head = NULL;
+    q->tail = NULL;
+    q->closed = 0;
+    
+    if(pthread_mutex_init(&(q->lock), NULL) != 0)
+        return -1;
+    
+    if(pthread_cond_init(&(q->cond), NULL) != 0) {
+        pthread_mutex_destroy(&(q->lock));
+        return -1;
+    }
+    
+    return 0;
+}
+
+void jqueue_destroy(struct jqueue* q) {
+    pthread_cond_destroy(&(q->cond));
+    pthread_mutex_destroy(&(q->lock));
+}
+
+void jqueue_push(struct jqueue* q, struct jqueue_node* n) {
+    n->next = NULL;
+    
+    pthread_mutex_lock(&(q->lock));
+    
+    if(q->tail == NULL)
+        q->head = n;
+    else
+        q->tail->next = n;
+    
+    q->tail = n;
+    pthread_cond_signal(&(q->cond));
+    pthread_mutex_unlock(&(q->lock));
+}
+
+struct jqueue_node* jqueue_pop(struct jqueue* q) {
+    struct jqueue_node* n;
+    
+    pthread_mutex_lock(&(q->lock));
+    
+    while(q->head == NULL && !q->closed)
+        pthread_cond_wait(&(q->cond), &(q->lock));
+    
+    n = jqueue_unlink(q);
+    pthread_mutex_unlock(&(q->lock));
+    
+    return n;
+}
+
+struct jqueue_node* jqueue_trypop(struct jqueue* q) {
+    struct jqueue_node* n;
+    
+    pthread_mutex_lock(&(q->lock));
+    n = jqueue_unlink(q);
+    pthread_mutex_unlock(&(q->lock));
+    
+    return n;
+}
+
+void jqueue_close(struct jqueue* q) {
+    pthread_mutex_lock(&(q->lock));
+    q->closed = 1;
+    pthread_cond_broadcast(&(q->cond));
+    pthread_mutex_unlock(&(q->lock));
+}
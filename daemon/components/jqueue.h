@@ -0,0 +1,96 @@
+/**
+ * @file jqueue.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the interface of a thread-safe FIFO queue of jobs
+ *
+ * This file contains the interface of a blocking FIFO queue used to
+ * hand work from one thread to another. The queue is intrusive: each
+ * job embeds a jqueue_node as its first member, so no allocation is
+ * performed by the queue itself.
+ */
+
+#ifndef JQUEUE_H
+#define JQUEUE_H
+
+#include <pthread.h>
+
+// ---------------------------------------------
+// DATA STRUCTURES
+// ---------------------------------------------
+
+/**
+ * @brief Represent the link embedded in each job
+ */
+struct jqueue_node {
+    struct jqueue_node*     next;   /** contains the pointer to next job in queue */
+};
+
+/**
+ * @brief Represent the queue object
+ * 
+ * The structure contains the first and the last job in the queue,
+ * the lock protecting them and the condition used by consumers to
+ * wait for new jobs. Once closed, consumers are no longer blocked.
+ */
+struct jqueue {
+    struct jqueue_node*     head;   /** contains the oldest job */
+    struct jqueue_node*     tail;   /** contains the newest job */
+    int                     closed; /** 1 if the queue does not accept waits anymore */
+    pthread_mutex_t         lock;   /** protects the queue */
+    pthread_cond_t          cond;   /** signaled on push and close */
+};
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+/**
+ * @brief Initialize the queue in order to be used
+ * 
+ * @param q pointer to the queue to be initialized
+ * @return -1 in case of error, 0 otherwise
+ */
+int jqueue_init(struct jqueue* q);
+
+/**
+ * @brief Release the resources of the queue
+ * 
+ * Jobs still in the queue are not freed.
+ * 
+ * @param q pointer to the queue
+ */
+void jqueue_destroy(struct jqueue* q);
+
+/**
+ * @brief Append a job to the queue and wake one consumer
+ * 
+ * @param q pointer to the queue
+ * @param n pointer to the node embedded in the job
+ */
+void jqueue_push(struct jqueue* q, struct jqueue_node* n);
+
+/**
+ * @brief Remove the oldest job, waiting if the queue is empty
+ * 
+ * @param q pointer to the queue
+ * @return the node of the job, NULL if the queue is closed and empty
+ */
+struct jqueue_node* jqueue_pop(struct jqueue* q);
+
+/**
+ * @brief Remove the oldest job without waiting
+ * 
+ * @param q pointer to the queue
+ * @return the node of the job, NULL if the queue is empty
+ */
+struct jqueue_node* jqueue_trypop(struct jqueue* q);
+
+/**
+ * @brief Close the queue and wake all consumers
+ * 
+ * @param q pointer to the queue
+ */
+void jqueue_close(struct jqueue* q);
+
+#endif
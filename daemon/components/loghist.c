@@ -0,0 +1,75 @@
+/**
+ * @file loghist.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a log-linear histogram of durations
+ */
+
+#include "loghist.h"
+
+// ---------------------------------------------
+// PUBLIC METHODS
+// ---------------------------------------------
+
+/**
+ * @internal
+ *
+ * The power of two of the value selects the group of buckets, the
+ * LOGHIST_SUB_BITS bits right below its leading one select the bucket
+ * in the group.
+ *
+ * @endinternal
+ */
+int loghist_bucket(uint64_t value) {
+    int msb;
+    
+    if(value < ((uint64_t)1 << LOGHIST_MIN_SHIFT))
+        return 0;
+    
+    msb = 63 - __builtin_clzll(value);
+    
+    if(msb >= LOGHIST_MAX_SHIFT)
+        return LOGHIST_NBUCKET - 1;
+    
+    return 1 + (msb - LOGHIST_MIN_SHIFT) * LOGHIST_SUB + ((value >> (msb - LOGHIST_SUB_BITS)) & (LOGHIST_SUB - 1));
+}
+
+uint64_t loghist_upper(int bucket) {
+    int msb;
+    
+    if(bucket <= 0)
+        return (uint64_t)1 << LOGHIST_MIN_SHIFT;
+    
+    msb = LOGHIST_MIN_SHIFT + (bucket - 1) / LOGHIST_SUB;
+    return (uint64_t)(LOGHIST_SUB + (bucket - 1) % LOGHIST_SUB + 1) << (msb - LOGHIST_SUB_BITS);
+}
+
+uint64_t loghist_quantile(const uint64_t* count, int nbucket, double q) {
+    uint64_t total = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    
+    for(int i = 0; i < nbucket; i++)
+        total += count[i];
+    
+    if(total == 0)
+        return 0;
+    
+    // smallest rank covering q of the samples, at least the first one
+    rank = q * total;
+    
+    if(rank < q * total)
+        rank++;
+    
+    if(rank == 0)
+        rank = 1;
+    
+    for(int i = 0; i < nbucket; i++) {
+        seen += count[i];
+    
+        if(seen >= rank)
+            return loghist_upper(i);
+    }
+    
+    return loghist_upper(nbucket - 1);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file loghist.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Log-linear histogram of durations
+ *
+ * This file contains the interface of loghist component. It maps a
+ * duration in nanoseconds to a bucket of a log-linear histogram: every
+ * power of two is split in LOGHIST_SUB linear buckets, so the width of
+ * a bucket is at most 1/LOGHIST_SUB of its lower bound. The geometry is
+ * fixed at compile time and the counters belong to the caller, so the
+ * histogram can live in shared memory and be filled without allocating.
+ */
+
+#ifndef LOGHIST_H
+#define LOGHIST_H
+
+#include <stdint.h>
+
+/**
+ * @brief Number of bits of the linear part of a bucket
+ */
+#define LOGHIST_SUB_BITS    3
+#define LOGHIST_SUB         (1 << LOGHIST_SUB_BITS)
+
+/**
+ * @brief Durations below 2^LOGHIST_MIN_SHIFT ns share the first bucket
+ */
+#define LOGHIST_MIN_SHIFT   10
+
+/**
+ * @brief Durations from 2^LOGHIST_MAX_SHIFT ns on share the last bucket
+ */
+#define LOGHIST_MAX_SHIFT   34
+
+/**
+ * @brief Number of buckets of the histogram
+ */
+#define LOGHIST_NBUCKET     (1 + (LOGHIST_MAX_SHIFT - LOGHIST_MIN_SHIFT) * LOGHIST_SUB)
+
+/**
+ * @brief Get the bucket of a duration
+ *
+ * @param value duration
+ * @return index of the bucket, in [0, LOGHIST_NBUCKET)
+ */
+int loghist_bucket(uint64_t value);
+
+/**
+ * @brief Get the upper bound of a bucket
+ *
+ * @param bucket index of the bucket
+ * @return the smallest duration above the bucket
+ */
+uint64_t loghist_upper(int bucket);
+
+/**
+ * @brief Get a quantile of the histogram
+ *
+ * The result is the upper bound of the bucket holding the quantile, so
+ * it is never below the durations that the quantile covers.
+ *
+ * @param count counters of the first @nbucket buckets
+ * @param nbucket number of counters, buckets above are empty
+ * @param q quantile, in [0, 1]
+ * @return the quantile, 0 if the histogram is empty
+ */
+uint64_t loghist_quantile(const uint64_t* count, int nbucket, double q);
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file prm.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of the periodic resource model
+ */
+
+#include "prm.h"
+
+// ---------------------------------------------
+// PUBLIC METHODS
+// ---------------------------------------------
+
+/**
+ * @internal
+ *
+ * With k the number of the period in which the interval ends, counted
+ * from the first full blackout, the supply grows with the interval while
+ * it overlaps the budget of period k + 1 and stays at (k - 1) * budget
+ * otherwise.
+ *
+ * @endinternal
+ */
+uint64_t prm_sbf(uint64_t period, uint64_t budget, uint64_t t) {
+    uint64_t gap = period - budget;
+    uint64_t k;
+    
+    if(budget == 0 || t <= gap)
+        return 0;
+    
+    k = (t - gap + period - 1) / period;
+    
+    if(t + 2 * budget >= (k + 1) * period && t + budget <= (k + 1) * period)
+        return t - (k + 1) * gap;
+    
+    return (k - 1) * budget;
+}
+
+/**
+ * @internal
+ *
+ * The demand of a task is at most its utilization times t + period -
+ * deadline, and the supply is at least budget / period times t - 2 *
+ * (period - budget): past the point where the two lines cross, the
+ * demand cannot exceed the supply any more. They cross only when the
+ * utilization of the set is below the bandwidth of the resource.
+ *
+ * @endinternal
+ */
+int prm_edf_test(const struct prm_task* set, int n, uint64_t period, uint64_t budget) {
+    double u = 0, slack = 0, alpha, bound;
+    uint64_t L, next, d, demand;
+    
+    if(n == 0)
+        return 1;
+    
+    if(period == 0 || budget == 0 || budget > period)
+        return 0;
+    
+    for(int i = 0; i < n; i++) {
+        if(set[i].period == 0 || set[i].wcet > set[i].deadline || set[i].deadline > set[i].period)
+            return 0;
+    
+        u += set[i].wcet / (double)set[i].period;
+        slack += (set[i].period - set[i].deadline) * (set[i].wcet / (double)set[i].period);
+    }
+    
+    alpha = budget / (double)period;
+    
+    if(u >= alpha)
+        return 0;
+    
+    bound = (slack + alpha * 2 * (period - budget)) / (alpha - u);
+    L = 0;
+    
+    for(int p = 0; p < PRM_MAX_POINTS; p++) {
+        next = 0;
+    
+        // next absolute deadline after L
+        for(int i = 0; i < n; i++) {
+            d = set[i].deadline;
+    
+            if(d <= L)
+                d += ((L - set[i].deadline) / set[i].period + 1) * set[i].period;
+    
+            if(next == 0 || d < next)
+                next = d;
+        }
+    
+        if(next > bound)
+            return 1;
+    
+        L = next;
+        demand = 0;
+    
+        for(int i = 0; i < n; i++)
+            if(L >= set[i].deadline)
+                demand += ((L - set[i].deadline) / set[i].period + 1) * set[i].wcet;
+    
+        if(demand > prm_sbf(period, budget, L))
+            return 0;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file prm.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Periodic resource model
+ *
+ * This file contains the interface of prm component. A periodic resource
+ * (period, budget) guarantees budget units of cpu time in every period,
+ * at no fixed time within it: this is the interface a group of tasks is
+ * admitted with, and the supply the tasks of the group are tested
+ * against. The supply bound function is the least time the resource
+ * provides in any interval, following Shin and Lee (RTSS 2003). All the
+ * times are in nanoseconds.
+ */
+
+#ifndef PRM_H
+#define PRM_H
+
+#include <stdint.h>
+
+/**
+ * @brief Absolute deadlines checked at most by prm_edf_test
+ */
+#define PRM_MAX_POINTS 100000
+
+/**
+ * @brief Represent a sporadic task tested on a periodic resource
+ */
+struct prm_task {
+    uint64_t    wcet;       /** worst case execution time [ns] */
+    uint64_t    deadline;   /** relative deadline, at most the period [ns] */
+    uint64_t    period;     /** minimum inter-arrival time [ns] */
+};
+
+/**
+ * @brief Get the supply bound function of a periodic resource
+ *
+ * In the worst case the budget of a period is given at its beginning
+ * and the one of the next period at its end, so an interval may get no
+ * supply for 2 * (period - budget).
+ *
+ * @param period period of the resource
+ * @param budget budget of the resource, at most the period
+ * @param t length of the interval
+ * @return the least time the resource supplies in any interval of length @t
+ */
+uint64_t prm_sbf(uint64_t period, uint64_t budget, uint64_t t);
+
+/**
+ * @brief Test a set of tasks scheduled by EDF on a periodic resource
+ *
+ * The demand bound function of the set must not exceed the supply bound
+ * function of the resource at any absolute deadline up to the bound of
+ * the busy period. The test gives up (unschedulable) after
+ * PRM_MAX_POINTS deadlines.
+ *
+ * @param set the tasks
+ * @param n number of tasks
+ * @param period period of the resource
+ * @param budget budget of the resource, at most the period
+ * @return 1 if the set is schedulable, 0 otherwise
+ */
+int prm_edf_test(const struct prm_task* set, int n, uint64_t period, uint64_t budget);
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file shring.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a single-producer single-consumer shared ring
+ */
+
+#define _GNU_SOURCE
+
+#include "shring.h"
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// ---------------------------------------------
+// PRIVATE METHODS
+// ---------------------------------------------
+
+/**
+ * @internal
+ *
+ * Size of the header rounded to a cache line, so that the first
+ * slot never shares a line with the consumer index.
+ * 
+ * @endinternal
+ */
+static size_t shring_hdr_size() {
+    return (sizeof(struct shring_hdr) + SHRING_CACHE_LINE - 1) & ~(size_t)(SHRING_CACHE_LINE - 1);
+}
+
+static int shring_map(struct shring* r, int fd, size_t len) {
+    void* addr;
+    
+    addr = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    
+    if(addr == MAP_FAILED)
+        return -1;
+    
+    r->fd = fd;
+    r->len = len;
+    r->hdr = addr;
+    r->data = (char*)addr + shring_hdr_size();
+    return 0;
+}
+
+static void* shring_slot(struct shring* r, uint64_t index) {
+    return r->data + (index & (r->nelem - 1)) * r->elem_size;
+}
+
+static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#endif
+}
+
+// ---------------------------------------------
+// PUBLIC METHODS
+// ---------------------------------------------
+
+int shring_create(struct shring* r, uint32_t nelem, uint32_t elem_size) {
+    int fd;
+    size_t len;
+    uint32_t size = 1;
+    
+    while(size < nelem)
+        size <<= 1;
+    
+    len = shring_hdr_size() + (size_t)size * elem_size;
+    fd = memfd_create("shring", MFD_CLOEXEC);
+    
+    if(fd < 0)
+        return -1;
+    
+    if(ftruncate(fd, len) < 0 || shring_map(r, fd, len) < 0) {
+        close(fd);
+        return -1;
+    }
+    
+    memset(r->hdr, 0, shring_hdr_size());
+    r->hdr->nelem = size;
+    r->hdr->elem_size = elem_size;
+    r->nelem = size;
+    r->elem_size = elem_size;
+    return 0;
+}
+
+/**
+ * @internal
+ *
+ * The geometry is read from the header once, checked and kept: the ring
+ * is never indexed through the header again.
+ *
+ * @endinternal
+ */
+int shring_open(struct shring* r, int fd) {
+    struct stat st;
+    uint32_t nelem, elem_size;
+    
+    if(fstat(fd, &st) < 0 || st.st_size < (off_t)shring_hdr_size())
+        return -1;
+    
+    if(shring_map(r, fd, st.st_size) < 0)
+        return -1;
+    
+    nelem = __atomic_load_n(&(r->hdr->nelem), __ATOMIC_RELAXED);
+    elem_size = __atomic_load_n(&(r->hdr->elem_size), __ATOMIC_RELAXED);
+    
+    if(nelem == 0 || (nelem & (nelem - 1)) != 0 || 
+       shring_hdr_size() + (size_t)nelem * elem_size > r->len) {
+        munmap(r->hdr, r->len);
+        return -1;
+    }
+    
+    r->nelem = nelem;
+    r->elem_size = elem_size;
+    return 0;
+}
+
+void shring_close(struct shring* r) {
+    munmap(r->hdr, r->len);
+    close(r->fd);
+}
+
+int shring_push(struct shring* r, const void* elem) {
+    uint64_t head, tail;
+    
+    head = atomic_read(&(r->hdr->head));
+    tail = atomic_read_acquire(&(r->hdr->tail));
+    
+    if(head - tail >= r->nelem)
+        return -1;
+    
+    memcpy(shring_slot(r, head), elem, r->elem_size);
+    atomic_set_release(&(r->hdr->head), head + 1);
+    return 0;
+}
+
+int shring_pop(struct shring* r, void* elem) {
+    uint64_t head, tail;
+    
+    tail = atomic_read(&(r->hdr->tail));
+    head = atomic_read_acquire(&(r->hdr->head));
+    
+    if(head == tail)
+        return -1;
+    
+    // a producer more than a ring ahead is broken: skip what it overwrote
+    if(head - tail > r->nelem)
+        tail = head - r->nelem;
+    
+    memcpy(elem, shring_slot(r, tail), r->elem_size);
+    atomic_set_release(&(r->hdr->tail), tail + 1);
+    return 0;
+}
+
+int shring_is_empty(struct shring* r) {
+    return atomic_read_acquire(&(r->hdr->head)) == atomic_read(&(r->hdr->tail));
+}
+
+void shring_wake(struct shring* r) {
+    __atomic_add_fetch(&(r->hdr->futex), 1, __ATOMIC_SEQ_CST);
+    
+    if(__atomic_load_n(&(r->hdr->waiters), __ATOMIC_SEQ_CST))
+        syscall(SYS_futex, &(r->hdr->futex), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+int shring_wait(struct shring* r, int spin, int ms) {
+    uint32_t seq;
+    struct timespec ts;
+    
+    for(int i = 0; i < spin; i++) {
+        if(!shring_is_empty(r))
+            return 0;
+        
+        cpu_relax();
+    }
+    
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    
+    seq = __atomic_load_n(&(r->hdr->futex), __ATOMIC_SEQ_CST);
+    
+    if(!shring_is_empty(r))
+        return 0;
+    
+    __atomic_add_fetch(&(r->hdr->waiters), 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &(r->hdr->futex), FUTEX_WAIT, seq, &ts, NULL, 0);
+    __atomic_sub_fetch(&(r->hdr->waiters), 1, __ATOMIC_SEQ_CST);
+    
+    return shring_is_empty(r) ? -1 : 0;
+}
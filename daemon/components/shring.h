@@ -0,0 +1,139 @@
+/**
+ * @file shring.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Single-producer single-consumer ring in shared memory
+ *
+ * This file contains the interface of shring component. It realizes
+ * a lock-free ring of fixed-size elements, backed by an anonymous
+ * memory file (memfd) that can be handed to another process and mapped
+ * there. Exactly one process may push and exactly one may pop. The
+ * consumer can block on the ring: the producer bumps a futex word on
+ * each push and wakes the consumer only if it is actually sleeping.
+ */
+
+#ifndef SHRING_H
+#define SHRING_H
+
+#include "atomic.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Alignment used to keep producer and consumer data on different lines
+ */
+#define SHRING_CACHE_LINE 64
+
+/**
+ * @brief Header placed at the beginning of the shared segment
+ * 
+ * Head is written only by the producer, tail only by the consumer.
+ * Each one lives in its own cache line to avoid false sharing.
+ */
+struct shring_hdr {
+    uint32_t    nelem;                                      /** Number of slots (power of two) */
+    uint32_t    elem_size;                                  /** Size of each slot */
+    atomic_t    head __attribute__((aligned(SHRING_CACHE_LINE)));   /** Next slot to write */
+    atomic_t    tail __attribute__((aligned(SHRING_CACHE_LINE)));   /** Next slot to read */
+    uint32_t    futex __attribute__((aligned(SHRING_CACHE_LINE)));  /** Bumped on each push */
+    uint32_t    waiters;                                    /** Consumers sleeping on futex */
+};
+
+/**
+ * @brief Represent the shring object
+ * 
+ * Local view of the ring: the memory file descriptor, the length of
+ * the mapping, pointers to header and slots and the geometry. The
+ * geometry is copied out of the header once checked, since the other
+ * process may write the header at any time.
+ */
+struct shring {
+    int                 fd;         /** Memory file descriptor */
+    size_t              len;        /** Length of the mapping */
+    struct shring_hdr*  hdr;        /** Pointer to the shared header */
+    char*               data;       /** Pointer to the first slot */
+    uint32_t            nelem;      /** Number of slots (power of two) */
+    uint32_t            elem_size;  /** Size of each slot */
+};
+
+/**
+ * @brief Create a new ring
+ * 
+ * Allocate a memory file large enough for @nelem elements of
+ * @elem_size bytes and map it. @nelem is rounded up to a power of two.
+ * 
+ * @param r pointer to shring struct to be created
+ * @param nelem number of slots
+ * @param elem_size size of each slot
+ * @return -1 in case of error, 0 otherwise
+ */
+int shring_create(struct shring* r, uint32_t nelem, uint32_t elem_size);
+
+/**
+ * @brief Map a ring created by another process
+ * 
+ * Map the memory file @fd received from the creator of the ring.
+ * The shring takes ownership of the descriptor.
+ * 
+ * @param r pointer to shring struct
+ * @param fd memory file descriptor of the ring
+ * @return -1 in case of error, 0 otherwise
+ */
+int shring_open(struct shring* r, int fd);
+
+/**
+ * @brief Unmap the ring and close its descriptor
+ * 
+ * @param r pointer to shring struct
+ */
+void shring_close(struct shring* r);
+
+/**
+ * @brief Push a copy of @elem (producer side)
+ * 
+ * @param r pointer to shring struct
+ * @param elem pointer to the element to be copied in the ring
+ * @return -1 if the ring is full, 0 otherwise
+ */
+int shring_push(struct shring* r, const void* elem);
+
+/**
+ * @brief Pop the oldest element into @elem (consumer side)
+ * 
+ * @param r pointer to shring struct
+ * @param elem pointer to the memory that receives the element
+ * @return -1 if the ring is empty, 0 otherwise
+ */
+int shring_pop(struct shring* r, void* elem);
+
+/**
+ * @brief Check if the ring is empty
+ * 
+ * @param r pointer to shring struct
+ * @return 1 if empty, 0 otherwise
+ */
+int shring_is_empty(struct shring* r);
+
+/**
+ * @brief Wake the consumer if it sleeps (producer side)
+ * 
+ * Must be called after one or more shring_push.
+ * 
+ * @param r pointer to shring struct
+ */
+void shring_wake(struct shring* r);
+
+/**
+ * @brief Wait until the ring holds at least one element (consumer side)
+ * 
+ * Busy-wait for @spin iterations, then sleep on the futex word
+ * for at most @ms milliseconds.
+ * 
+ * @param r pointer to shring struct
+ * @param spin number of polling iterations before sleeping
+ * @param ms maximum sleeping time in milliseconds
+ * @return 0 if an element is available, -1 on timeout
+ */
+int shring_wait(struct shring* r, int spin, int ms);
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * @file slab.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a fixed-size object allocator
+ */
+
+#include "slab.h"
+#include <stdlib.h>
+
+#define SLAB_ALIGN  16
+
+// ---------------------------------------------
+// PRIVATE METHODS
+// ---------------------------------------------
+
+/**
+ * @internal
+ *
+ * The chunk starts with the link to the previous chunk, padded to the
+ * alignment of the objects, followed by per_chunk objects which are
+ * all pushed to the free list.
+ *
+ * @endinternal
+ */
+static int slab_grow(struct slab* s) {
+    char* chunk;
+    struct slab_obj* obj;
+    
+    chunk = malloc(SLAB_ALIGN + s->size * s->per_chunk);
+    
+    if(chunk == NULL)
+        return -1;
+    
+    ((struct slab_obj*)chunk)->next = s->chunks;
+    s->chunks = (struct slab_obj*)chunk;
+    s->nchunks++;
+    
+    for(size_t i = s->per_chunk; i > 0; i--) {
+        obj = (struct slab_obj*)(chunk + SLAB_ALIGN + (i - 1) * s->size);
+        obj->next = s->free;
+        s->free = obj;
+    }
+    
+    return 0;
+}
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+void slab_init(struct slab* s, size_t size, size_t per_chunk) {
+    if(size < sizeof(struct slab_obj))
+        size = sizeof(struct slab_obj);
+    
+    s->size = (size + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+    s->per_chunk = per_chunk > 0 ? per_chunk : 1;
+    s->free = NULL;
+    s->chunks = NULL;
+    s->nchunks = 0;
+    s->used = 0;
+}
+
+void slab_destroy(struct slab* s) {
+    struct slab_obj* next;
+    
+    while(s->chunks != NULL) {
+        next = s->chunks->next;
+        free(s->chunks);
+        s->chunks = next;
+    }
+    
+    slab_init(s, s->size, s->per_chunk);
+}
+
+void* slab_alloc(struct slab* s) {
+    struct slab_obj* obj;
+    
+    if(s->free == NULL && slab_grow(s) < 0)
+        return NULL;
+    
+    obj = s->free;
+    s->free = obj->next;
+    s->used++;
+    return obj;
+}
+
+void slab_free(struct slab* s, void* obj) {
+    if(obj == NULL)
+        return;
+    
+    ((struct slab_obj*)obj)->next = s->free;
+    s->free = obj;
+    s->used--;
+}
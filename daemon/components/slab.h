@@ -0,0 +1,89 @@
+/**
+ * @file slab.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the interface of a fixed-size object allocator
+ *
+ * This file contains the interface of a slab: a pool of objects of a
+ * single size carved out of chunks obtained from the heap. Freed
+ * objects are kept in a free list and handed out again, chunks are
+ * returned to the heap only when the slab is destroyed, so the memory
+ * of an owner stays flat once it has seen its peak population. The
+ * slab is not thread-safe: each slab must be used by one thread.
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+// ---------------------------------------------
+// DATA STRUCTURES
+// ---------------------------------------------
+
+/**
+ * @brief Represent the link of a free object
+ */
+struct slab_obj {
+    struct slab_obj*    next;       /** contains the next free object */
+};
+
+/**
+ * @brief Represent the slab object
+ *
+ * The structure contains the size of the objects, the number of
+ * objects carved out of each chunk, the list of free objects and the
+ * list of the chunks owned by the slab.
+ */
+struct slab {
+    size_t              size;       /** contains the size of each object */
+    size_t              per_chunk;  /** contains the number of objects per chunk */
+    struct slab_obj*    free;       /** contains the list of free objects */
+    struct slab_obj*    chunks;     /** contains the list of chunks */
+    size_t              nchunks;    /** contains the number of chunks */
+    size_t              used;       /** contains the number of objects handed out */
+};
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+/**
+ * @brief Initialize the slab in order to be used
+ *
+ * No memory is obtained until the first allocation.
+ *
+ * @param s pointer to the slab to be initialized
+ * @param size size of each object
+ * @param per_chunk number of objects obtained from the heap at once
+ */
+void slab_init(struct slab* s, size_t size, size_t per_chunk);
+
+/**
+ * @brief Release the chunks of the slab
+ *
+ * Objects still handed out become invalid.
+ *
+ * @param s pointer to the slab
+ */
+void slab_destroy(struct slab* s);
+
+/**
+ * @brief Take an object from the slab
+ *
+ * The content of the object is undefined.
+ *
+ * @param s pointer to the slab
+ * @return the object, NULL if a new chunk cannot be obtained
+ */
+void* slab_alloc(struct slab* s);
+
+/**
+ * @brief Give an object back to the slab
+ *
+ * @param s pointer to the slab
+ * @param obj object obtained from the same slab, NULL is ignored
+ */
+void slab_free(struct slab* s, void* obj);
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file tscclock.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a nanosecond clock read from the time stamp counter
+ */
+
+#include "tscclock.h"
+#include <time.h>
+
+#ifdef __x86_64__
+    #include <cpuid.h>
+#endif
+
+#define TSCCLOCK_PAIR_TRIES 8
+
+// ---------------------------------------------
+// PRIVATE METHODS
+// ---------------------------------------------
+
+#ifdef __x86_64__
+
+static int tscclock_invariant() {
+    unsigned int eax, ebx, ecx, edx;
+    
+    if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return 0;
+    
+    return (edx >> 8) & 1;
+}
+
+/**
+ * @internal
+ *
+ * The monotonic time is taken between two reads of the counter and
+ * matched with their middle; the tightest of a few tries is kept, so a
+ * preemption in between does not skew the scale.
+ *
+ * @endinternal
+ */
+static void tscclock_pair(uint64_t* cyc, uint64_t* ns) {
+    struct timespec ts;
+    unsigned int aux;
+    uint64_t before, after, best = UINT64_MAX;
+    
+    for(int i = 0; i < TSCCLOCK_PAIR_TRIES; i++) {
+        before = __rdtscp(&aux);
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        after = __rdtscp(&aux);
+    
+        if(after - before >= best)
+            continue;
+    
+        best = after - before;
+        *cyc = before + best / 2;
+        *ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+}
+
+#endif
+
+// ---------------------------------------------
+// PUBLIC METHODS
+// ---------------------------------------------
+
+int tscclock_init(struct tscclock* c, uint64_t window) {
+#ifdef __x86_64__
+    struct timespec ts;
+    uint64_t cyc0, ns0, cyc1, ns1;
+    
+    if(!tscclock_invariant())
+        return -1;
+    
+    tscclock_pair(&cyc0, &ns0);
+    ts.tv_sec = window / 1000000000;
+    ts.tv_nsec = window % 1000000000;
+    nanosleep(&ts, NULL);
+    tscclock_pair(&cyc1, &ns1);
+    
+    if(cyc1 <= cyc0 || ns1 <= ns0)
+        return -1;
+    
+    c->mult = ((unsigned __int128)(ns1 - ns0) << TSCCLOCK_SHIFT) / (cyc1 - cyc0);
+    c->base_cyc = cyc1;
+    c->base_ns = ns1;
+    return 0;
+#else
+    (void)c;
+    (void)window;
+    return -1;
+#endif
+}
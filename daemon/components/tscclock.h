@@ -0,0 +1,67 @@
+/**
+ * @file tscclock.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Nanosecond clock read from the time stamp counter
+ *
+ * This file contains the interface of tscclock component. It turns the
+ * time stamp counter of the processor into nanoseconds, with a scale
+ * measured once against CLOCK_MONOTONIC. Reading it takes no system
+ * call, so it is meant for timestamps taken on hot paths. It is only
+ * available when the counter is invariant, i.e. it ticks at a constant
+ * rate on every cpu and in every power state.
+ */
+
+#ifndef TSCCLOCK_H
+#define TSCCLOCK_H
+
+#include <stdint.h>
+
+#ifdef __x86_64__
+    #include <x86intrin.h>
+#endif
+
+/**
+ * @brief Fraction bits of the scale
+ */
+#define TSCCLOCK_SHIFT 32
+
+/**
+ * @brief Represent the tscclock object
+ */
+struct tscclock {
+    uint64_t    base_cyc;   /** Counter value at calibration */
+    uint64_t    base_ns;    /** CLOCK_MONOTONIC at calibration [ns] */
+    uint64_t    mult;       /** Nanoseconds per cycle, fixed point */
+};
+
+/**
+ * @brief Calibrate the clock
+ *
+ * Measure the rate of the counter against CLOCK_MONOTONIC over @window
+ * nanoseconds; the caller sleeps meanwhile.
+ *
+ * @param c pointer to tscclock struct to be calibrated
+ * @param window length of the measure [ns]
+ * @return -1 if the counter is missing or not invariant, 0 otherwise
+ */
+int tscclock_init(struct tscclock* c, uint64_t window);
+
+/**
+ * @brief Read the clock
+ *
+ * @param c pointer to a calibrated tscclock struct
+ * @return the time, in the timeline of CLOCK_MONOTONIC [ns]
+ */
+static inline uint64_t tscclock_now(const struct tscclock* c) {
+#ifdef __x86_64__
+	unsigned int aux;
+	uint64_t cyc = __rdtscp(&aux);
+
+	return c->base_ns + (uint64_t)(((unsigned __int128)(cyc - c->base_cyc) * c->mult) >> TSCCLOCK_SHIFT);
+#else
+	return 0;
+#endif
+}
+
+#endif
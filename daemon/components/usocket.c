@@ -1,4 +1,7 @@
+#define _GNU_SOURCE
+
 #include "usocket.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/un.h>
@@ -20,6 +23,7 @@ int usocket_init(struct usocket* us, int socktype) {
     us->socket = sock;
     us->conn_set_max = 0;
     us->filepath = NULL;
+    us->epoll_fd = -1;
     FD_ZERO(&(us->conn_set));
     return 0;
 }
@@ -55,6 +59,10 @@ int usocket_send(struct usocket* us, void* elem, size_t size) {
     return send(us->socket, elem, size, 0);
 }
 
+int usocket_recv_wait(struct usocket* us, void* elem, size_t size) {
+    return recv(us->socket, elem, size, MSG_WAITALL);
+}
+
 /** Put server awaiting for connection on binded address/port and return 0 in case of success or -1 otherwise
     Argument: int sock, int max_req
     Return: int */
@@ -100,7 +108,7 @@ int usocket_recvfrom(struct usocket* us, void* elem, size_t size, int i) {
 }
 
 int usocket_sendto(struct usocket* us, void* elem, size_t size, int i) {
-    return send(i, elem, size, 0);
+    return send(i, elem, size, MSG_NOSIGNAL);
 }
 
 int usocket_nonblock(struct usocket* us) {
@@ -176,5 +184,264 @@ int usocket_add_connections(struct usocket* us) {
 }
 
 void usocket_remove_connections(struct usocket* us, int fd) {
-    FD_CLR(fd, &(us->conn_set));
+    if(fd < SET_MAX_SIZE)
+        FD_CLR(fd, &(us->conn_set));
+    
+    if(us->epoll_fd >= 0)
+        epoll_ctl(us->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    
+    close(fd);
+}
+
+/** Accept every pending connection on the (non-blocking) listening socket and
+    register each one in edge-triggered mode. Descriptors that would not fit the
+    per-client tables of the caller are refused. When the daemon runs out of
+    descriptors or memory the rest of the backlog is left for usocket_wait to
+    retry, as the listening socket will not signal it again.
+    Argument: usocket* us
+    Return: void */
+static void usocket_accept_all(struct usocket* us) {
+    int newfd;
+    struct epoll_event ev;
+    
+    us->accept_due = 0;
+    
+    while(1) {
+        newfd = accept4(us->socket, NULL, NULL, SOCK_NONBLOCK);
+        
+        if(newfd < 0 && (errno == EINTR || errno == ECONNABORTED))
+            continue;
+        
+        if(newfd < 0) {
+            if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+                us->accept_due = 1;
+            
+            return;
+        }
+        
+        if(newfd >= EPOLL_MAX_SIZE) {
+            close(newfd);
+            continue;
+        }
+        
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = newfd;
+        
+        if(epoll_ctl(us->epoll_fd, EPOLL_CTL_ADD, newfd, &ev) < 0) {
+            close(newfd);
+            continue;
+        }
+        
+        us->conn_set_max = us->conn_set_max > newfd ? us->conn_set_max : newfd;
+    }
+}
+
+int usocket_prepare_epoll(struct usocket* us) {
+    struct epoll_event ev;
+    
+    us->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    
+    if(us->epoll_fd < 0)
+        return -1;
+    
+    if(usocket_nonblock(us) < 0)
+        return -1;
+    
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = us->socket;
+    us->conn_set_max = us->socket;
+    
+    return epoll_ctl(us->epoll_fd, EPOLL_CTL_ADD, us->socket, &ev);
+}
+
+/** Wait until at least one client has something to say. New connections are
+    accepted internally; only the descriptors of clients that became readable
+    (data, hang-up or error) are copied into ready. Since the sockets are
+    edge-triggered, the caller must drain each returned fd with
+    usocket_recvnext until it fails with EAGAIN. While a backlog is left by
+    usocket_accept_all, the wait is bounded by ACCEPT_RETRY_WAIT [ms] and the
+    connections are accepted again on every wake-up.
+    Argument: usocket* us, int ready[]
+    Return: number of ready clients, or -1 */
+int usocket_wait(struct usocket* us, int ready[EPOLL_MAX_EVENTS]) {
+    int i, n, nready;
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    
+    n = epoll_wait(us->epoll_fd, events, EPOLL_MAX_EVENTS, us->accept_due ? ACCEPT_RETRY_WAIT : -1);
+    
+    if(n < 0)
+        return errno == EINTR ? 0 : -1;
+    
+    // a wake-up may have freed descriptors, retry the backlog before anything else
+    if(us->accept_due)
+        usocket_accept_all(us);
+    
+    nready = 0;
+    
+    for(i = 0; i < n; i++) {
+        if(events[i].data.fd == us->socket)
+            usocket_accept_all(us);
+        else
+            ready[nready++] = events[i].data.fd;
+    }
+    
+    return nready;
+}
+
+int usocket_recvnext(struct usocket* us, void* elem, size_t size, int fd) {
+    return recv(fd, elem, size, MSG_DONTWAIT);
+}
+
+/** Reads the next message of a non-blocking client along with up to nfds
+    descriptors (SCM_RIGHTS), returns the descriptors count in nfds
+    Argument: usocket* us, void* elem, size_t size, int fd, int* fds, int* nfds
+    Return: int */
+int usocket_recvnext_fds(struct usocket* us, void* elem, size_t size, int fd, int* fds, int* nfds) {
+    int n;
+    int got;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr* cmsg;
+    char ctrl[CMSG_SPACE(sizeof(int) * USOCKET_MAX_FDS)];
+    
+    memset(&msg, 0, sizeof(struct msghdr));
+    iov.iov_base = elem;
+    iov.iov_len = size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    got = 0;
+    
+    n = recvmsg(fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    
+    for(cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL; cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+        
+        // descriptors nobody asked for are not leaked
+        for(int i = 0; i < (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int)); i++) {
+            if(got < *nfds)
+                fds[got++] = ((int*)CMSG_DATA(cmsg))[i];
+            else
+                close(((int*)CMSG_DATA(cmsg))[i]);
+        }
+    }
+    
+    *nfds = got;
+    return n;
+}
+
+/** Adds an auxiliary descriptor to the epoll set. Its events are reported as id
+    Argument: struct usocket*, int fd, int id
+    Return: int */
+int usocket_watch(struct usocket* us, int fd, int id) {
+    struct epoll_event ev;
+    
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = id;
+    
+    return epoll_ctl(us->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/** Removes an auxiliary descriptor from the epoll set and closes it
+    Argument: struct usocket*, int fd
+    Return: void */
+void usocket_unwatch(struct usocket* us, int fd) {
+    epoll_ctl(us->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+}
+
+/** Sends a message along with nfds descriptors (SCM_RIGHTS) on connection fd
+    Argument: struct usocket*, void* elem, size_t size, int fd, int* fds, int nfds
+    Return: int */
+int usocket_sendto_fds(struct usocket* us, void* elem, size_t size, int fd, int* fds, int nfds) {
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr* cmsg;
+    char ctrl[CMSG_SPACE(sizeof(int) * USOCKET_MAX_FDS)];
+    
+    if(nfds <= 0 || nfds > USOCKET_MAX_FDS)
+        return -1;
+    
+    memset(&msg, 0, sizeof(struct msghdr));
+    memset(ctrl, 0, sizeof(ctrl));
+    iov.iov_base = elem;
+    iov.iov_len = size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+    
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+    
+    return sendmsg(fd, &msg, MSG_NOSIGNAL);
+}
+
+/** Receives a message and up to nfds descriptors, returns the descriptors count in nfds
+    Argument: struct usocket*, void* elem, size_t size, int* fds, int* nfds
+    Return: int */
+int usocket_recv_fds(struct usocket* us, void* elem, size_t size, int* fds, int* nfds) {
+    int n;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr* cmsg;
+    char ctrl[CMSG_SPACE(sizeof(int) * USOCKET_MAX_FDS)];
+    
+    memset(&msg, 0, sizeof(struct msghdr));
+    iov.iov_base = elem;
+    iov.iov_len = size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    
+    n = recvmsg(us->socket, &msg, MSG_WAITALL | MSG_CMSG_CLOEXEC);
+    
+    if(n <= 0) {
+        *nfds = 0;
+        return n;
+    }
+    
+    for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int got = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            
+            if(got > *nfds) {
+                // too many descriptors, do not leak the extra ones
+                for(int i = *nfds; i < got; i++)
+                    close(((int*)CMSG_DATA(cmsg))[i]);
+                got = *nfds;
+            }
+            
+            memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * got);
+            *nfds = got;
+            return n;
+        }
+    }
+    
+    *nfds = 0;
+    return n;
+}
+
+/** Checks, without consuming data, whether the peer closed the connection
+    Argument: struct usocket*
+    Return: int */
+int usocket_is_alive(struct usocket* us) {
+    int n;
+    char c;
+    
+    n = recv(us->socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    
+    if(n == 0)
+        return 0;
+    
+    if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        return 0;
+    
+    return 1;
 }
@@ -13,6 +13,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/epoll.h>
        
 // ---------------------------------------------
 // DATA STRUCTURES
@@ -25,11 +26,19 @@
 #define BACKLOG_MAX 128
 #define SET_MAX_SIZE FD_SETSIZE
 
+#define EPOLL_MAX_EVENTS 128
+#define EPOLL_MAX_SIZE 16384
+#define ACCEPT_RETRY_WAIT 50
+
+#define USOCKET_MAX_FDS 8
+
 struct usocket {
     int socket;
     char* filepath;
     int conn_set_max;
     fd_set conn_set;
+    int epoll_fd;
+    int accept_due;     // connections left in the backlog, see usocket_wait
 };
 
 // 
@@ -50,6 +59,12 @@ int usocket_recv(struct usocket* us, void* elem, size_t size);
 
 int usocket_send(struct usocket* us, void* elem, size_t size);
 
+int usocket_recv_wait(struct usocket* us, void* elem, size_t size);
+
+int usocket_recv_fds(struct usocket* us, void* elem, size_t size, int* fds, int* nfds);
+
+int usocket_is_alive(struct usocket* us);
+
 // 
 // SPECIFIC FOR SERVERS
 //
@@ -80,4 +95,22 @@ int usocket_get_maxfd(struct usocket* us);
 
 void usocket_prepare_recv(struct usocket* us);
 
+// 
+// SPECIFIC FOR SERVERS (EPOLL)
+//
+
+int usocket_prepare_epoll(struct usocket* us);
+
+int usocket_wait(struct usocket* us, int ready[EPOLL_MAX_EVENTS]);
+
+int usocket_recvnext(struct usocket* us, void* elem, size_t size, int fd);
+
+int usocket_recvnext_fds(struct usocket* us, void* elem, size_t size, int fd, int* fds, int* nfds);
+
+int usocket_sendto_fds(struct usocket* us, void* elem, size_t size, int fd, int* fds, int nfds);
+
+int usocket_watch(struct usocket* us, int fd, int id);
+
+void usocket_unwatch(struct usocket* us, int fd);
+
 #endif
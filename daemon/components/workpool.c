@@ -0,0 +1,138 @@
+/**
+ * @file workpool.c
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the implementation of a fixed pool of worker threads
+ */
+
+#include "workpool.h"
+#include <signal.h>
+#include <stdlib.h>
+
+// ---------------------------------------------
+// PRIVATE METHODS
+// ---------------------------------------------
+
+static void workpool_drain(struct workpool* p) {
+    int i;
+    
+    while((i = __atomic_fetch_add(&(p->next), 1, __ATOMIC_RELAXED)) < p->n)
+        p->fn(p->arg, i);
+}
+
+static void* workpool_worker(void* arg) {
+    struct workpool* p = arg;
+    unsigned long seen = 0;
+    
+    while(1) {
+        pthread_mutex_lock(&(p->lock));
+        
+        while(p->round == seen && !p->stop)
+            pthread_cond_wait(&(p->start), &(p->lock));
+        
+        if(p->stop) {
+            pthread_mutex_unlock(&(p->lock));
+            return NULL;
+        }
+        
+        seen = p->round;
+        pthread_mutex_unlock(&(p->lock));
+        
+        workpool_drain(p);
+        
+        pthread_mutex_lock(&(p->lock));
+        
+        if(--p->busy == 0)
+            pthread_cond_signal(&(p->done));
+        
+        pthread_mutex_unlock(&(p->lock));
+    }
+}
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+int workpool_init(struct workpool* p, int nthreads) {
+    sigset_t all, old;
+    
+    p->nthreads = 0;
+    p->round = 0;
+    p->stop = 0;
+    p->busy = 0;
+    p->n = 0;
+    p->next = 0;
+    p->threads = NULL;
+    
+    if(pthread_mutex_init(&(p->lock), NULL) != 0)
+        return -1;
+    
+    pthread_cond_init(&(p->start), NULL);
+    pthread_cond_init(&(p->done), NULL);
+    
+    if(nthreads <= 0)
+        return 0;
+    
+    p->threads = calloc(nthreads, sizeof(pthread_t));
+    
+    if(p->threads == NULL)
+        return -1;
+    
+    // workers inherit a mask with every signal blocked
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    
+    for(int i = 0; i < nthreads; i++) {
+        if(pthread_create(&(p->threads[i]), NULL, workpool_worker, p) != 0)
+            break;
+        
+        p->nthreads++;
+    }
+    
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    
+    return 0;
+}
+
+void workpool_destroy(struct workpool* p) {
+    pthread_mutex_lock(&(p->lock));
+    p->stop = 1;
+    pthread_cond_broadcast(&(p->start));
+    pthread_mutex_unlock(&(p->lock));
+    
+    for(int i = 0; i < p->nthreads; i++)
+        pthread_join(p->threads[i], NULL);
+    
+    free(p->threads);
+    pthread_cond_destroy(&(p->start));
+    pthread_cond_destroy(&(p->done));
+    pthread_mutex_destroy(&(p->lock));
+}
+
+void workpool_run(struct workpool* p, int n, workpool_fn fn, void* arg) {
+    if(p->nthreads == 0) {
+        for(int i = 0; i < n; i++)
+            fn(arg, i);
+        
+        return;
+    }
+    
+    pthread_mutex_lock(&(p->lock));
+    p->fn = fn;
+    p->arg = arg;
+    p->n = n;
+    p->next = 0;
+    p->busy = p->nthreads;
+    p->round++;
+    pthread_cond_broadcast(&(p->start));
+    pthread_mutex_unlock(&(p->lock));
+    
+    workpool_drain(p);
+    
+    pthread_mutex_lock(&(p->lock));
+    
+    while(p->busy > 0)
+        pthread_cond_wait(&(p->done), &(p->lock));
+    
+    pthread_mutex_unlock(&(p->lock));
+}
@@ -0,0 +1,87 @@
+/**
+ * @file workpool.h
+ * @author Gabriele Serra
+ * @date 16 Oct 2026
+ * @brief Contains the interface of a fixed pool of worker threads
+ *
+ * This file contains the interface of a minimal parallel-for. The
+ * caller hands a function and a number of independent items; items
+ * are distributed among the workers and the calling thread, and the
+ * call returns once all of them have been processed. Workers never
+ * receive asynchronous signals.
+ */
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <pthread.h>
+
+// ---------------------------------------------
+// DATA STRUCTURES
+// ---------------------------------------------
+
+/**
+ * @brief Function applied to each item
+ * 
+ * @param arg argument given to workpool_run
+ * @param i index of the item, in [0, n)
+ */
+typedef void (*workpool_fn)(void* arg, int i);
+
+/**
+ * @brief Represent the pool object
+ * 
+ * The structure contains the worker threads and the description of
+ * the current round: function, argument, number of items and the
+ * index of the next item to be taken.
+ */
+struct workpool {
+    int                 nthreads;   /** number of worker threads */
+    pthread_t*          threads;    /** worker threads */
+    pthread_mutex_t     lock;       /** protects the round description */
+    pthread_cond_t      start;      /** signaled when a round starts or the pool stops */
+    pthread_cond_t      done;       /** signaled when the last worker ends a round */
+    unsigned long       round;      /** number of the current round */
+    int                 stop;       /** 1 if workers must exit */
+    int                 busy;       /** workers still in the current round */
+    workpool_fn         fn;         /** function of the current round */
+    void*               arg;        /** argument of the current round */
+    int                 n;          /** items of the current round */
+    int                 next;       /** next item to be taken */
+};
+
+// ---------------------------------------------
+// MAIN METHODS
+// ---------------------------------------------
+
+/**
+ * @brief Start a pool of @nthreads workers
+ * 
+ * With @nthreads equal to 0 every round runs on the calling thread.
+ * 
+ * @param p pointer to the pool to be initialized
+ * @param nthreads number of worker threads
+ * @return -1 in case of error, 0 otherwise
+ */
+int workpool_init(struct workpool* p, int nthreads);
+
+/**
+ * @brief Stop the workers and release the pool
+ * 
+ * @param p pointer to the pool
+ */
+void workpool_destroy(struct workpool* p);
+
+/**
+ * @brief Apply @fn to the items 0..n-1 and wait for all of them
+ * 
+ * Must not be called concurrently on the same pool.
+ * 
+ * @param p pointer to the pool
+ * @param n number of items
+ * @param fn function applied to each item
+ * @param arg argument passed to each call
+ */
+void workpool_run(struct workpool* p, int n, workpool_fn fn, void* arg);
+
+#endif
@@ -1,18 +1,19 @@
 // TODO -> sostituire tutte le printf con syslog
 
 #include "lib/rts_daemon.h"
+#include "lib/rts_utils.h"
 #include <stdio.h>
 #include <signal.h>
 #include <stdlib.h>
 
-#define TIMER_INTERVAL 500
-
 struct rts_daemon data;
 
 void term() {
-    printf("\nRTS daemon was signaled. It will destroy data and stop.\n");
-    rts_daemon_destroy(&data);
-    exit(EXIT_SUCCESS);
+    rts_daemon_stop(&data);
+}
+
+void reeval() {
+    rts_daemon_reeval(&data);
 }
 
 void exit_err(char* str) {
@@ -27,7 +28,17 @@ int main(int argc, char* argv[]) {
         exit_err("Something gone wrong in the init phase.\n");
     
     rts_daemon_register_sig_int(term);
+    
+    if(data.reeval_period > 0) {
+        rts_daemon_register_sig_alarm(reeval);
+        set_timer(data.reeval_period);
+    }
+    
     rts_daemon_loop(&data);
     
-    return 0;
+    set_timer(0);
+    printf("\nRTS daemon was signaled. It will destroy data and stop.\n");
+    rts_daemon_destroy(&data);
+    
+    return EXIT_SUCCESS;
 }
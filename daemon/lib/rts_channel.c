@@ -1,9 +1,18 @@
 #include "rts_channel.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/sysinfo.h>
 
 // ACCESS ----
 
 int rts_access_init(struct rts_access* c) {
+    c->use_ring = 0;
+    rts_snapshot_init(&(c->snap));
+    
     if(usocket_init(&(c->sock), TCP) < 0)
         return -1;
     //if(usocket_timeout(&(c->sock), CHANNEL_TIMEOUT) < 0)
@@ -16,18 +25,125 @@ int rts_access_connect(struct rts_access* c) {
     return usocket_connect(&(c->sock), CHANNEL_PATH_ACCESS);
 }
 
+static int rts_access_ring_recv(struct rts_access* c) {
+    while(shring_wait(&(c->ring.rep), c->ring.spin, CHANNEL_TIMEOUT) < 0) {
+        // nothing yet, give up only if the daemon is gone
+        if(!usocket_is_alive(&(c->sock)))
+            return 0;
+    }
+    
+    if(shring_pop(&(c->ring.rep), (void *)&(c->rep)) < 0)
+        return -1;
+    
+    return sizeof(struct rts_reply);
+}
+
+static int rts_access_ring_send(struct rts_access* c) {
+    uint64_t one = 1;
+    
+    if(shring_push(&(c->ring.req), (void *)&(c->req)) < 0)
+        return -1;
+    
+    if(write(c->ring.doorbell, &one, sizeof(uint64_t)) < 0)
+        return -1;
+    
+    return sizeof(struct rts_request);
+}
+
 int rts_access_recv(struct rts_access* c) {
+    if(c->use_ring)
+        return rts_access_ring_recv(c);
+    
     return usocket_recv(&(c->sock), (void *)&(c->rep), sizeof(struct rts_reply));
 }
 
 int rts_access_send(struct rts_access* c) {
+    if(c->use_ring)
+        return rts_access_ring_send(c);
+    
     return usocket_send(&(c->sock), (void *)&(c->req), sizeof(struct rts_request));
 }
 
+int rts_access_ring_open(struct rts_access* c) {
+    int nfds = 3;
+    int fds[3];
+    
+    c->req.req_type = RTS_RING_SETUP;
+    
+    if(usocket_send(&(c->sock), (void *)&(c->req), sizeof(struct rts_request)) < 0)
+        return -1;
+    
+    if(usocket_recv_fds(&(c->sock), (void *)&(c->rep), sizeof(struct rts_reply), fds, &nfds) <= 0)
+        return -1;
+    
+    if(c->rep.rep_type != RTS_RING_SETUP_OK || nfds != 3) {
+        for(int i = 0; i < nfds; i++)
+            close(fds[i]);
+        return -1;
+    }
+    
+    if(shring_open(&(c->ring.req), fds[0]) < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        close(fds[2]);
+        return -1;
+    }
+    
+    if(shring_open(&(c->ring.rep), fds[1]) < 0) {
+        shring_close(&(c->ring.req));
+        close(fds[1]);
+        close(fds[2]);
+        return -1;
+    }
+    
+    // spinning only helps when the daemon runs on another cpu
+    c->ring.doorbell = fds[2];
+    c->ring.spin = get_nprocs() > 1 ? CHANNEL_RING_SPIN : 0;
+    c->use_ring = 1;
+    return 0;
+}
+
+void rts_access_ring_close(struct rts_access* c) {
+    if(!c->use_ring)
+        return;
+    
+    shring_close(&(c->ring.req));
+    shring_close(&(c->ring.rep));
+    close(c->ring.doorbell);
+    c->use_ring = 0;
+}
+
+// hands the estimator table of the process over to the daemon, once per connection
+int rts_access_est_setup(struct rts_access* c, int fd) {
+    c->req.req_type = RTS_EST_SETUP;
+    
+    if(usocket_sendto_fds(&(c->sock), (void *)&(c->req), sizeof(struct rts_request), c->sock.socket, &fd, 1) < 0)
+        return -1;
+    
+    if(usocket_recv(&(c->sock), (void *)&(c->rep), sizeof(struct rts_reply)) <= 0)
+        return -1;
+    
+    return c->rep.rep_type == RTS_EST_SETUP_OK ? 0 : -1;
+}
+
+int rts_access_send_batch(struct rts_access* c, struct rts_batch* b) {
+    b->req[0].req_type = RTS_BATCH;
+    b->req[0].payload.nreq = b->nreq;
+    
+    return usocket_send(&(c->sock), (void *)b->req, (b->nreq + 1) * sizeof(struct rts_request));
+}
+
+int rts_access_recv_batch(struct rts_access* c, struct rts_batch* b) {
+    return usocket_recv_wait(&(c->sock), (void *)b->rep, b->nreq * sizeof(struct rts_reply));
+}
+
 // CARRIER ----
 
 int rts_carrier_init(struct rts_carrier* c) {
-    memset(c, 0, sizeof(struct rts_access));
+    memset(c, 0, sizeof(struct rts_carrier));
+    
+    for(int i = 0; i < CHANNEL_MAX_SIZE; i++)
+        c->last_fd[i] = -1;
 
     if(usocket_init(&(c->sock), TCP) < 0) 
         return -1;
@@ -41,8 +157,8 @@ int rts_carrier_init(struct rts_carrier* c) {
     return 0;
 }
 
-void rts_carrier_prepare(struct rts_carrier* c) {
-    usocket_prepare_recv(&(c->sock));
+int rts_carrier_prepare(struct rts_carrier* c) {
+    return usocket_prepare_epoll(&(c->sock));
 }
 
 int rts_carrier_get_conn(struct rts_carrier* c) {
@@ -69,28 +185,90 @@ void rts_carrier_set_pid(struct rts_carrier* c, int cli_id, pid_t pid) {
     c->client[cli_id].pid = pid;
 }
 
-void rts_carrier_update(struct rts_carrier* c) {
-    int i, n;
-
-    n = usocket_get_maxfd(&(c->sock));
-    memset(&(c->last_n), 0, n+1);
+int rts_carrier_update(struct rts_carrier* c) {
+    int i, n, id;
     
-    usocket_recvall(&(c->sock), (void*)&(c->last_req), (int*)&(c->last_n), sizeof(struct rts_request));
+    n = usocket_wait(&(c->sock), c->ready);
+    c->ready_num = 0;
+    c->ready_gen++;
     
-    for(i = 0; i <= n; i++) {
-        if(i == c->sock.socket)
-            continue;
-        else if(c->client[i].state == EMPTY && c->last_n[i] == 0)
+    // socket and doorbell of the same client may both be ready
+    for(i = 0; i < n; i++) {
+        id = c->ready[i];
+        
+        if(c->ready_seen[id] == c->ready_gen)
             continue;
-        else if(c->client[i].state == EMPTY && c->last_n[i] != 0)
-            c->client[i].state = CONNECTED;
-        else if(c->client[i].state == CONNECTED && c->last_n[i] > 0)
-            continue;
-        else if(c->last_n[i] < 0)
-            c->client[i].state = ERROR;
-        else
-            c->client[i].state = DISCONNECTED;   
+        
+        c->ready_seen[id] = c->ready_gen;
+        
+        if(c->ring[id] != NULL)
+            c->kick[id] = 1;
+        
+        c->ready[c->ready_num++] = id;
+    }
+    
+    return c->ready_num;
+}
+
+int rts_carrier_get_ready(struct rts_carrier* c, int i) {
+    return c->ready[i];
+}
+
+static int rts_carrier_ring_recv(struct rts_carrier* c, int cli_id) {
+    uint64_t v;
+    struct rts_ring* r = c->ring[cli_id];
+    
+    // rearm the doorbell before draining, a later push will ring it again
+    if(c->kick[cli_id]) {
+        c->kick[cli_id] = 0;
+        
+        if(read(r->doorbell, &v, sizeof(uint64_t)) < 0 && errno != EAGAIN)
+            return -1;
+    }
+    
+    if(shring_pop(&(r->req), (void*)&(c->last_req[cli_id])) < 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    
+    c->last_src[cli_id] = CHANNEL_SRC_RING;
+    return sizeof(struct rts_request);
+}
+
+// a descriptor travels with the request that uses it, one not taken by
+// then is dropped
+static void rts_carrier_drop_fd(struct rts_carrier* c, int cli_id) {
+    if(c->last_fd[cli_id] < 0)
+        return;
+    
+    close(c->last_fd[cli_id]);
+    c->last_fd[cli_id] = -1;
+}
+
+int rts_carrier_recv(struct rts_carrier* c, int cli_id) {
+    int n;
+    int nfds = 1;
+    
+    rts_carrier_drop_fd(c, cli_id);
+    c->last_n[cli_id] = 0;
+    c->last_src[cli_id] = CHANNEL_SRC_SOCKET;
+    n = usocket_recvnext_fds(&(c->sock), (void*)&(c->last_req[cli_id]), sizeof(struct rts_request), cli_id, &(c->last_fd[cli_id]), &nfds);
+    
+    if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && c->ring[cli_id] != NULL)
+        n = rts_carrier_ring_recv(c, cli_id);
+    
+    if(n > 0) {
+        c->last_n[cli_id] = n;
+        
+        if(c->client[cli_id].state == EMPTY)
+            c->client[cli_id].state = CONNECTED;
     }
+    else if(n == 0)
+        c->client[cli_id].state = DISCONNECTED;
+    else if(errno != EAGAIN && errno != EWOULDBLOCK)
+        c->client[cli_id].state = ERROR;
+    
+    return c->last_n[cli_id];
 }
 
 int rts_carrier_isupdated(struct rts_carrier* c, int cli_id) {
@@ -104,10 +282,195 @@ void rts_carrier_setpid(struct rts_carrier* c, int cli_id, pid_t pid) {
     c->client[cli_id].pid = pid;
 }
 
-void rts_carrier_rm_conn(struct rts_access* cd) {
-    return;
+static void rts_carrier_ring_free(struct rts_carrier* c, int cli_id) {
+    struct rts_ring* r = c->ring[cli_id];
+    
+    if(r == NULL)
+        return;
+    
+    usocket_unwatch(&(c->sock), r->doorbell);
+    shring_close(&(r->req));
+    shring_close(&(r->rep));
+    free(r);
+    c->ring[cli_id] = NULL;
+}
+
+static void rts_carrier_est_free(struct rts_carrier* c, int cli_id) {
+    if(c->est[cli_id] == NULL)
+        return;
+    
+    estable_close(c->est[cli_id]);
+    free(c->est[cli_id]);
+    c->est[cli_id] = NULL;
+}
+
+void rts_carrier_rm_conn(struct rts_carrier* c, int cli_id) {
+    rts_carrier_ring_free(c, cli_id);
+    rts_carrier_est_free(c, cli_id);
+    free(c->body[cli_id]);
+    c->body[cli_id] = NULL;
+    rts_carrier_drop_fd(c, cli_id);
+    usocket_remove_connections(&(c->sock), cli_id);
+    
+    c->client[cli_id].state = EMPTY;
+    c->client[cli_id].pid = 0;
+    c->last_n[cli_id] = 0;
+    c->last_src[cli_id] = CHANNEL_SRC_SOCKET;
+    c->kick[cli_id] = 0;
+}
+
+int rts_carrier_ring_setup(struct rts_carrier* c, int cli_id) {
+    struct rts_ring* r;
+    
+    if(c->ring[cli_id] != NULL)
+        return -1;
+    
+    r = calloc(1, sizeof(struct rts_ring));
+    
+    if(r == NULL)
+        return -1;
+    
+    if(shring_create(&(r->req), CHANNEL_RING_SIZE, sizeof(struct rts_request)) < 0)
+        goto err_req;
+    
+    if(shring_create(&(r->rep), CHANNEL_RING_SIZE, sizeof(struct rts_reply)) < 0)
+        goto err_rep;
+    
+    r->doorbell = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    
+    if(r->doorbell < 0)
+        goto err_bell;
+    
+    if(usocket_watch(&(c->sock), r->doorbell, cli_id) < 0)
+        goto err_watch;
+    
+    c->ring[cli_id] = r;
+    return 0;
+    
+err_watch:
+    close(r->doorbell);
+err_bell:
+    shring_close(&(r->rep));
+err_rep:
+    shring_close(&(r->req));
+err_req:
+    free(r);
+    return -1;
+}
+
+// maps the estimator table received along with the last request
+int rts_carrier_est_setup(struct rts_carrier* c, int cli_id) {
+    struct estable* t;
+    
+    if(c->est[cli_id] != NULL || c->last_fd[cli_id] < 0)
+        return -1;
+    
+    t = malloc(sizeof(struct estable));
+    
+    if(t == NULL)
+        return -1;
+    
+    if(estable_open(t, c->last_fd[cli_id], EST_NVALUE) < 0) {
+        free(t);
+        return -1;
+    }
+    
+    c->last_fd[cli_id] = -1;
+    c->est[cli_id] = t;
+    return 0;
+}
+
+atomic_t* rts_carrier_est_slot(struct rts_carrier* c, int cli_id, uint32_t slot) {
+    if(c->est[cli_id] == NULL)
+        return NULL;
+    
+    return estable_slot(c->est[cli_id], slot);
+}
+
+int rts_carrier_watch(struct rts_carrier* c, int fd) {
+    // reported by rts_carrier_get_ready under its own descriptor number
+    if(fd >= CHANNEL_MAX_SIZE)
+        return -1;
+    
+    return usocket_watch(&(c->sock), fd, fd);
 }
 
 int rts_carrier_send(struct rts_carrier* c, struct rts_reply* r, int cli_id) {
+    struct rts_ring* ring = c->ring[cli_id];
+    
+    if(c->last_src[cli_id] == CHANNEL_SRC_RING) {
+        if(shring_push(&(ring->rep), (void*)r) < 0)
+            return -1;
+        
+        shring_wake(&(ring->rep));
+        return sizeof(struct rts_reply);
+    }
+    
+    // the first reply after the setup hands the ring over to the client
+    if(ring != NULL && !ring->shared) {
+        int fds[3] = { ring->req.fd, ring->rep.fd, ring->doorbell };
+        
+        ring->shared = 1;
+        return usocket_sendto_fds(&(c->sock), (void*)r, sizeof(struct rts_reply), cli_id, fds, 3);
+    }
+    
     return usocket_sendto(&(c->sock), (void*)r, sizeof(struct rts_reply), cli_id);
 }
+
+// Reads what has arrived of a batch body of nreq requests, the one left
+// pending by a previous call if any. The I/O thread never waits for the rest:
+// the next EPOLLIN of the client resumes the read. Returns the number of
+// requests once the body is complete, 0 while it is not, -1 on error.
+int rts_carrier_recv_batch(struct rts_carrier* c, int cli_id, uint32_t nreq) {
+    int n;
+    size_t size;
+    struct rts_batch_body* b = c->body[cli_id];
+    
+    if(b == NULL || b->nreq == 0) {
+        // batch bodies travel on the socket only
+        if(c->last_src[cli_id] == CHANNEL_SRC_RING || nreq == 0 || nreq > CHANNEL_BATCH_MAX)
+            return -1;
+        
+        if(b == NULL && (b = malloc(sizeof(struct rts_batch_body))) == NULL)
+            return -1;
+        
+        c->body[cli_id] = b;
+        b->nreq = nreq;
+        b->got = 0;
+    }
+    
+    size = b->nreq * sizeof(struct rts_request);
+    
+    while(b->got < size) {
+        n = usocket_recvnext(&(c->sock), (char*)b->req + b->got, size - b->got, cli_id);
+        
+        if(n > 0) {
+            b->got += n;
+            continue;
+        }
+        
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return 0;
+        
+        c->client[cli_id].state = n == 0 ? DISCONNECTED : ERROR;
+        return -1;
+    }
+    
+    nreq = b->nreq;
+    b->nreq = 0;
+    
+    return nreq;
+}
+
+uint32_t rts_carrier_batch_pending(struct rts_carrier* c, int cli_id) {
+    return c->body[cli_id] != NULL ? c->body[cli_id]->nreq : 0;
+}
+
+// the body completed by the last rts_carrier_recv_batch
+struct rts_request* rts_carrier_get_batch(struct rts_carrier* c, int cli_id) {
+    return c->body[cli_id] != NULL ? c->body[cli_id]->req : NULL;
+}
+
+int rts_carrier_send_batch(struct rts_carrier* c, struct rts_reply* rep, uint32_t nrep, int cli_id) {
+    return usocket_sendto(&(c->sock), (void*)rep, nrep * sizeof(struct rts_reply), cli_id);
+}
@@ -2,24 +2,69 @@
 #define RTS_CHANNEL_H
 
 #include "rts_types.h"
+#include "rts_snapshot.h"
 #include "../components/usocket.h"
+#include "../components/shring.h"
+#include "../components/estable.h"
 
 #define CHANNEL_PATH_CARRIER "/tmp/channel"
 #define CHANNEL_PATH_ACCESS "/tmp/channel"
-#define CHANNEL_MAX_SIZE SET_MAX_SIZE
+#define CHANNEL_MAX_SIZE EPOLL_MAX_SIZE
 #define CHANNEL_TIMEOUT 150
+#define CHANNEL_BATCH_MAX 128
+#define CHANNEL_RING_SIZE 16
+#define CHANNEL_RING_SPIN 20000
+
+enum CHANNEL_SRC {
+    CHANNEL_SRC_SOCKET,
+    CHANNEL_SRC_RING
+};
+
+struct rts_ring {
+    int doorbell;               // eventfd, client -> daemon notification
+    int shared;                 // descriptors already handed to the client
+    int spin;                   // polling iterations before sleeping on a reply
+    struct shring req;          // client produces, daemon consumes
+    struct shring rep;          // daemon produces, client consumes
+};
 
 struct rts_access {
     struct usocket sock;
+    int use_ring;
+    struct rts_ring ring;
+    struct rts_snapshot snap;
     struct rts_request req;
     struct rts_reply rep;
 };
 
+struct rts_batch {
+    uint32_t nreq;
+    struct rts_request req[CHANNEL_BATCH_MAX + 1];  // req[0] is the batch header
+    struct rts_reply rep[CHANNEL_BATCH_MAX];
+};
+
+// body of a batch, collected across reads as it arrives
+struct rts_batch_body {
+    uint32_t nreq;              // 0 once the body is complete
+    size_t got;                 // [bytes]
+    struct rts_request req[CHANNEL_BATCH_MAX];
+};
+
 struct rts_carrier {
     struct usocket sock;
+    int ready_num;
+    int ready[EPOLL_MAX_EVENTS];
     int last_n[CHANNEL_MAX_SIZE];
     struct rts_request last_req[CHANNEL_MAX_SIZE];
     struct rts_client client[CHANNEL_MAX_SIZE];
+    struct rts_ring* ring[CHANNEL_MAX_SIZE];
+    struct estable* est[CHANNEL_MAX_SIZE];
+    struct rts_batch_body* body[CHANNEL_MAX_SIZE];
+    int last_fd[CHANNEL_MAX_SIZE];
+    char last_src[CHANNEL_MAX_SIZE];
+    char kick[CHANNEL_MAX_SIZE];
+    unsigned int ready_gen;
+    unsigned int ready_seen[CHANNEL_MAX_SIZE];
 };
 
 // ACCESS ----
@@ -32,15 +77,27 @@ int rts_access_recv(struct rts_access* c);
 
 int rts_access_send(struct rts_access* c);
 
+int rts_access_send_batch(struct rts_access* c, struct rts_batch* b);
+
+int rts_access_recv_batch(struct rts_access* c, struct rts_batch* b);
+
+int rts_access_ring_open(struct rts_access* c);
+
+void rts_access_ring_close(struct rts_access* c);
+
+int rts_access_est_setup(struct rts_access* c, int fd);
+
 // CARRIER ---------
 
 int rts_carrier_init(struct rts_carrier* c);
 
-void rts_carrier_prepare(struct rts_carrier* c);
+int rts_carrier_prepare(struct rts_carrier* c);
 
 int rts_carrier_get_conn(struct rts_carrier* c);
 
-void rts_carrier_update(struct rts_carrier* c);
+int rts_carrier_update(struct rts_carrier* c);
+
+int rts_carrier_get_ready(struct rts_carrier* c, int i);
 
 void rts_carrier_select(struct rts_carrier* c, struct rts_request arr[CHANNEL_MAX_SIZE]);
 
@@ -54,12 +111,30 @@ void rts_carrier_set_pid(struct rts_carrier* c, int cli_id, pid_t pid);
 
 int rts_carrier_get_size(struct rts_carrier* c);
 
-void rts_carrier_recv(struct rts_carrier* c, struct rts_request* req, int i);
+int rts_carrier_recv(struct rts_carrier* c, int cli_id);
 
 int rts_carrier_send(struct rts_carrier* c, struct rts_reply* rep, int i);
 
+int rts_carrier_recv_batch(struct rts_carrier* c, int cli_id, uint32_t nreq);
+
+uint32_t rts_carrier_batch_pending(struct rts_carrier* c, int cli_id);
+
+struct rts_request* rts_carrier_get_batch(struct rts_carrier* c, int cli_id);
+
+int rts_carrier_send_batch(struct rts_carrier* c, struct rts_reply* rep, uint32_t nrep, int cli_id);
+
 struct rts_request rts_carrier_get_req(struct rts_carrier* c, int cli_id);
 
 struct rts_client* rts_carrier_get_client(struct rts_carrier* c, int cli_id);
 
+void rts_carrier_rm_conn(struct rts_carrier* c, int cli_id);
+
+int rts_carrier_ring_setup(struct rts_carrier* c, int cli_id);
+
+int rts_carrier_watch(struct rts_carrier* c, int fd);
+
+int rts_carrier_est_setup(struct rts_carrier* c, int cli_id);
+
+atomic_t* rts_carrier_est_slot(struct rts_carrier* c, int cli_id, uint32_t slot);
+
 #endif	// RTS_CHANNEL_H
@@ -0,0 +1,86 @@
+#include "rts_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONFIG_LINE_MAX 128
+
+static struct rts_config_opt* rts_config_find(struct rts_config* cfg, const char* key) {
+    for(int i = 0; i < cfg->num_of_opt; i++)
+        if(!strcmp(cfg->opt[i].key, key))
+            return &(cfg->opt[i]);
+    
+    return NULL;
+}
+
+int rts_config_load(struct rts_config* cfg, const char* path) {
+    FILE* f;
+    char line[CONFIG_LINE_MAX];
+    char key[CONFIG_KEY_MAX];
+    char value[CONFIG_VALUE_MAX];
+    struct rts_config_opt* opt;
+    
+    memset(cfg, 0, sizeof(struct rts_config));
+    f = fopen(path, "r");
+    
+    if(f == NULL)
+        return -1;
+    
+    while(fgets(line, CONFIG_LINE_MAX, f) != NULL) {
+        if(line[0] == '!')
+            break;
+        
+        if(line[0] != '@')
+            continue;
+        
+        if(sscanf(line + 1, "%31s %63s", key, value) != 2)
+            continue;
+        
+        opt = rts_config_find(cfg, key);
+        
+        if(opt == NULL) {
+            if(cfg->num_of_opt == CONFIG_MAX_OPTS)
+                continue;
+            
+            opt = &(cfg->opt[cfg->num_of_opt++]);
+            strcpy(opt->key, key);
+        }
+        
+        strcpy(opt->value, value);
+    }
+    
+    fclose(f);
+    return 0;
+}
+
+const char* rts_config_get_str(struct rts_config* cfg, const char* key, const char* def) {
+    struct rts_config_opt* opt = rts_config_find(cfg, key);
+    
+    return opt != NULL ? opt->value : def;
+}
+
+long rts_config_get_long(struct rts_config* cfg, const char* key, long def) {
+    char* end;
+    long val;
+    struct rts_config_opt* opt = rts_config_find(cfg, key);
+    
+    if(opt == NULL)
+        return def;
+    
+    val = strtol(opt->value, &end, 10);
+    
+    return *end == '\0' ? val : def;
+}
+
+double rts_config_get_double(struct rts_config* cfg, const char* key, double def) {
+    char* end;
+    double val;
+    struct rts_config_opt* opt = rts_config_find(cfg, key);
+    
+    if(opt == NULL)
+        return def;
+    
+    val = strtod(opt->value, &end);
+    
+    return *end == '\0' ? val : def;
+}
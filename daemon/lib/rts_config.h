@@ -0,0 +1,28 @@
+#ifndef RTS_CONFIG_H
+#define RTS_CONFIG_H
+
+#define CONFIG_MAX_OPTS 32
+#define CONFIG_KEY_MAX 32
+#define CONFIG_VALUE_MAX 64
+
+// Options are lines "@ key value" placed before the plugin table ('!')
+// of the configuration file. Later definitions override earlier ones.
+struct rts_config_opt {
+    char key[CONFIG_KEY_MAX];
+    char value[CONFIG_VALUE_MAX];
+};
+
+struct rts_config {
+    int num_of_opt;
+    struct rts_config_opt opt[CONFIG_MAX_OPTS];
+};
+
+int rts_config_load(struct rts_config* cfg, const char* path);
+
+const char* rts_config_get_str(struct rts_config* cfg, const char* key, const char* def);
+
+long rts_config_get_long(struct rts_config* cfg, const char* key, long def);
+
+double rts_config_get_double(struct rts_config* cfg, const char* key, double def);
+
+#endif	// RTS_CONFIG_H
@@ -6,10 +6,15 @@
 
 #include "../components/logger.h"
 #include "rts_daemon.h"
+#include "rts_plugin.h"
 #include "rts_utils.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 
 void remove_rt_kernel_limit(int* rt_period, int* rt_runtime) {
@@ -58,6 +63,38 @@ static struct rts_reply req_connection(struct rts_daemon* data, int cli_id, pid_
     return rep;
 }
 
+static struct rts_reply req_ring_setup(struct rts_daemon* data, int cli_id) {
+    struct rts_reply rep;
+    
+    LOG("Received RING SETUP REQ from client %d\n", cli_id);
+    
+    // the ring is negotiated on the socket, once per connection
+    if(rts_carrier_ring_setup(&(data->chann), cli_id) < 0) {
+        LOG("Unable to set up the ring for client %d\n", cli_id);
+        rep.rep_type = RTS_RING_SETUP_ERR;
+        return rep;
+    }
+    
+    rep.rep_type = RTS_RING_SETUP_OK;
+    return rep;
+}
+
+static struct rts_reply req_est_setup(struct rts_daemon* data, int cli_id) {
+    struct rts_reply rep;
+    
+    LOG("Received EST SETUP REQ from client %d\n", cli_id);
+    
+    // the table arrives on the socket along with the request, once per connection
+    if(rts_carrier_est_setup(&(data->chann), cli_id) < 0) {
+        LOG("Unable to map the estimator table of client %d\n", cli_id);
+        rep.rep_type = RTS_EST_SETUP_ERR;
+        return rep;
+    }
+    
+    rep.rep_type = RTS_EST_SETUP_OK;
+    return rep;
+}
+
 static struct rts_reply req_refresh_sys(struct rts_daemon* data) {
     int cpu_overl;
     struct rts_reply rep;
@@ -114,6 +151,18 @@ static struct rts_reply req_cap_query(struct rts_daemon* data, enum QUERY_TYPE t
             rep.rep_type = RTS_CAP_QUERY_OK;
             LOG("System average remaining utilization: %f\n", rep.payload);
             break;
+        case RTS_PACKING_EFFICIENCY:
+            LOG("Received CAP_PACKING_EFFICIENCY REQ.\n");
+            rep.payload = rts_scheduler_get_packing_efficiency(&(data->sched));
+            rep.rep_type = RTS_CAP_QUERY_OK;
+            LOG("Packing efficiency (%s): %f\n", rts_scheduler_placement_str(data->sched.placement), rep.payload);
+            break;
+        case RTS_ACCEPTANCE_RATIO:
+            LOG("Received CAP_ACCEPTANCE_RATIO REQ.\n");
+            rep.payload = rts_scheduler_get_acceptance_ratio(&(data->sched));
+            rep.rep_type = RTS_CAP_QUERY_OK;
+            LOG("Acceptance ratio: %f\n", rep.payload);
+            break;
         default:
             LOG("Received invalid CAP REQ.\n");
             rep.rep_type = RTS_CAP_QUERY_ERR;
@@ -142,6 +191,30 @@ static struct rts_reply req_rsv_create(struct rts_daemon* data, struct rts_param
     return rep;
 }
 
+static struct rts_reply req_rsv_create_attach(struct rts_daemon* data, struct rts_create_attach* ca, pid_t ppid) {
+    int ret;
+    rsv_t rsv_id;
+    struct rts_reply rep;
+    
+    LOG("Received RSV_CREATE_ATTACH REQ from pid: %d. PID: %d will be attached.\n", ppid, ca->pid);
+    ret = rts_scheduler_rsv_create_attach(&(data->sched), &(ca->param), ppid, ca->pid, &rsv_id);
+    rep.payload = -1;
+    
+    if(ret == -1) {
+        rep.rep_type = RTS_RSV_CREATE_ERR;
+        LOG("It is NOT possible to guarantee these parameters!\n");
+    } else if(ret < 0) {
+        rep.rep_type = RTS_RSV_ATTACH_ERR;
+        LOG("Parameters admitted but the thread could not be scheduled. Rolled back.\n");
+    } else {
+        rep.rep_type = RTS_RSV_CREATE_OK;
+        rep.payload = rsv_id;
+        LOG("Parameters guaranteed and thread attached. Res. id: %d\n", rsv_id);
+    }
+    
+    return rep;
+}
+
 static struct rts_reply req_rsv_attach(struct rts_daemon* data, rsv_t rsvid, pid_t pid) {
     struct rts_reply rep;
     
@@ -202,17 +275,176 @@ static struct rts_reply req_rsv_destroy(struct rts_daemon* data, rsv_t rsvid) {
     return rep;
 }
 
+static struct rts_job* rts_daemon_job_alloc(struct rts_daemon* data, int cli_id, enum JOB_TYPE type) {
+    struct rts_job* job;
+    
+    job = slab_alloc(&(data->job_slab));
+    
+    if(job == NULL)
+        return NULL;
+    
+    memset(job, 0, sizeof(struct rts_job));
+    job->type = type;
+    job->cli_id = cli_id;
+    job->pid = rts_carrier_get_client(&(data->chann), cli_id)->pid;
+    
+    return job;
+}
+
+static void rts_daemon_job_free(struct rts_daemon* data, struct rts_job* job) {
+    slab_free(&(data->batch_slab), job->batch);
+    slab_free(&(data->job_slab), job);
+}
+
+static void rts_daemon_job_post(struct rts_daemon* data, struct rts_job* job) {
+    // no further request of this client is read until the job completes
+    data->job_state[job->cli_id] = job->type == JOB_TEARDOWN ? JOB_CLOSING : JOB_PENDING;
+    jqueue_push(&(data->jobs), &(job->node));
+}
+
+static struct rts_reply rts_daemon_dispatch_req(struct rts_daemon* data, pid_t ppid, struct rts_request* req);
+
+// utilization declared by a reservation request, -1 for other requests
+static float rts_daemon_req_util(struct rts_request* req) {
+    struct rts_params* p;
+    
+    if(req->req_type == RTS_RSV_CREATE)
+        p = &(req->payload.param);
+    else if(req->req_type == RTS_RSV_CREATE_ATTACH)
+        p = &(req->payload.create_attach.param);
+    else
+        return -1;
+    
+    return p->period > 0 ? p->budget / (float)p->period : 0;
+}
+
+// runs of consecutive creations are admitted by decreasing utilization
+// (stable), any other request keeps its place; replies keep their slots
+static void rts_daemon_run_batch(struct rts_daemon* data, struct rts_job* job) {
+    uint32_t i, j, k;
+    uint32_t order[CHANNEL_BATCH_MAX];
+    float util[CHANNEL_BATCH_MAX];
+    
+    for(i = 0; i < job->nreq; i++) {
+        order[i] = i;
+        util[i] = rts_daemon_req_util(&(job->batch->req[i]));
+    }
+    
+    if(data->batch_order == BATCH_DECREASING) {
+        for(i = 1; i < job->nreq; i++) {
+            k = order[i];
+            
+            if(util[k] < 0)
+                continue;
+            
+            for(j = i; j > 0 && util[order[j - 1]] >= 0 && util[order[j - 1]] < util[k]; j--)
+                order[j] = order[j - 1];
+            
+            order[j] = k;
+        }
+    }
+    
+    for(i = 0; i < job->nreq; i++)
+        job->batch->rep[order[i]] = rts_daemon_dispatch_req(data, job->pid, &(job->batch->req[order[i]]));
+}
+
+static void* rts_daemon_sched_loop(void* arg) {
+    uint64_t one = 1;
+    struct rts_job* job;
+    struct rts_daemon* data = arg;
+    
+    while((job = (struct rts_job*)jqueue_pop(&(data->jobs))) != NULL) {
+        switch(job->type) {
+            case JOB_REQUEST:
+                job->rep = rts_daemon_dispatch_req(data, job->pid, &(job->req));
+                break;
+            case JOB_BATCH:
+                rts_daemon_run_batch(data, job);
+                break;
+            case JOB_TEARDOWN:
+                rts_scheduler_delete(&(data->sched), job->pid);
+                data->snap_dirty = 1;
+                break;
+            case JOB_REEVAL:
+                job->result = rts_scheduler_reevaluate(&(data->sched));
+                rts_scheduler_end_request(&(data->sched));
+                data->snap_dirty = 1;
+                break;
+        }
+        
+        rts_daemon_publish(data);
+        jqueue_push(&(data->done), &(job->node));
+        
+        if(write(data->done_fd, &one, sizeof(uint64_t)) < 0)
+            LOG("Unable to notify a completed job.\n");
+    }
+    
+    return NULL;
+}
+
 int rts_daemon_init(struct rts_daemon* data) {
     int rt_period;
     int rt_runtime; 
+    sigset_t all, old;
     
+    slab_init(&(data->job_slab), sizeof(struct rts_job), DAEMON_JOB_CHUNK);
+    slab_init(&(data->batch_slab), sizeof(struct rts_job_batch), 1);
     remove_rt_kernel_limit(&rt_period, &rt_runtime);
     
     if(rts_carrier_init(&(data->chann)) < 0)
         return -1;
     
     rts_taskset_init(&(data->tasks));
+    
+    // signals are handled by the I/O thread only
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
     rts_scheduler_init(&(data->sched), &(data->tasks), rt_period, rt_runtime);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    
+    data->reeval_period = rts_config_get_long(&(data->sched.config), "reeval_period_ms", DAEMON_REEVAL_MS);
+    data->reeval_due = 0;
+    data->reeval_pending = 0;
+    data->teardown_due = 0;
+    
+    if(!strcmp(rts_config_get_str(&(data->sched.config), "batch_order", "DECREASING"), "ARRIVAL"))
+        data->batch_order = BATCH_ARRIVAL;
+    else
+        data->batch_order = BATCH_DECREASING;
+    
+    LOG("Placement policy: %s - Batch order: %s - Re-evaluation period: %ld ms\n", 
+        rts_scheduler_placement_str(data->sched.placement),
+        data->batch_order == BATCH_ARRIVAL ? "ARRIVAL" : "DECREASING", data->reeval_period);
+    LOG("Estimated wcet: %.1f percentile of the execution times + %.1f%%\n", 
+        data->sched.wcet_quantile * 100, data->sched.wcet_margin * 100);
+    LOG("Budget controller: %s\n", rts_scheduler_controller_str(data->sched.controller));
+    
+    // clients fall back to CAP_QUERY requests without the snapshot
+    if(rts_snapshot_create(&(data->snap)) < 0)
+        LOG("Unable to create the capacity snapshot.\n");
+    
+    data->snap_dirty = 1;
+    rts_daemon_publish(data);
+    
+    data->stop = 0;
+    memset(data->job_state, JOB_NONE, sizeof(data->job_state));
+    data->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    
+    if(data->done_fd < 0)
+        return -1;
+    
+    if(jqueue_init(&(data->jobs)) < 0 || jqueue_init(&(data->done)) < 0)
+        return -1;
+    
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    
+    if(pthread_create(&(data->sched_thread), NULL, rts_daemon_sched_loop, data) != 0) {
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+        return -1;
+    }
+    
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
         
     return 0;
 }
@@ -225,7 +457,37 @@ void rts_daemon_register_sig_alarm(void (*func)(int)) {
     signal(SIGALRM, func);
 }
 
+void rts_daemon_stop(struct rts_daemon* data) {
+    data->stop = 1;
+}
+
+void rts_daemon_reeval(struct rts_daemon* data) {
+    data->reeval_due = 1;
+}
+
+// one re-evaluation at a time: ticks arriving meanwhile are dropped
+static void rts_daemon_post_reeval(struct rts_daemon* data) {
+    struct rts_job* job;
+    
+    data->reeval_due = 0;
+    
+    if(data->reeval_pending)
+        return;
+    
+    job = slab_alloc(&(data->job_slab));
+    
+    if(job == NULL)
+        return;
+    
+    memset(job, 0, sizeof(struct rts_job));
+    job->type = JOB_REEVAL;
+    job->cli_id = -1;
+    data->reeval_pending = 1;
+    jqueue_push(&(data->jobs), &(job->node));
+}
+
 int rts_daemon_check_for_fail(struct rts_daemon* data, int cli_id) {
+    struct rts_job* job;
     struct rts_client* client;
     
     client = rts_carrier_get_client(&(data->chann), cli_id);
@@ -233,13 +495,41 @@ int rts_daemon_check_for_fail(struct rts_daemon* data, int cli_id) {
     if(client->state != ERROR && client->state != DISCONNECTED)
         return 0;
     
+    if(data->job_state[cli_id] == JOB_CLOSING)
+        return 1;
+    
     LOG("Client %d disconnected. Its reservation will be destroyed.\n", cli_id);
-    rts_carrier_set_state(&(data->chann), cli_id, EMPTY);
-    rts_scheduler_delete(&(data->sched), client->pid);
+    job = rts_daemon_job_alloc(data, cli_id, JOB_TEARDOWN);
+    
+    if(job == NULL) {
+        // the client stays disconnected until the loop queues its teardown,
+        // dropping it now would leak its reservations
+        LOG("Unable to queue the teardown of client %d, will retry.\n", cli_id);
+        data->teardown_due = 1;
+        return 1;
+    }
+    
+    // the connection is dropped once the scheduler thread is done with it
+    rts_daemon_job_post(data, job);
     
     return 1;
 }
 
+// the sockets of the failed clients will not signal again, look them up
+static void rts_daemon_retry_teardown(struct rts_daemon* data) {
+    int i;
+    struct rts_client* client;
+    
+    data->teardown_due = 0;
+    
+    for(i = 0; i < CHANNEL_MAX_SIZE; i++) {
+        client = rts_carrier_get_client(&(data->chann), i);
+        
+        if(data->job_state[i] == JOB_NONE && (client->state == ERROR || client->state == DISCONNECTED))
+            rts_daemon_check_for_fail(data, i);
+    }
+}
+
 int rts_daemon_check_for_update(struct rts_daemon* data, int cli_id) {
     int is_updated;
     struct rts_client* client;
@@ -260,56 +550,228 @@ void rts_daemon_set_fail(struct rts_daemon* data, int cli_id) {
     client->state = ERROR;
 }
 
+void rts_daemon_publish(struct rts_daemon* data) {
+    int i, c;
+    float used;
+    struct rts_plugin* plg;
+    struct rts_snapshot_data* d;
+    struct rts_scheduler* s = &(data->sched);
+    
+    if(data->snap.data == NULL || !data->snap_dirty)
+        return;
+    
+    d = rts_snapshot_write_begin(&(data->snap));
+    d->valid = 1;
+    d->num_of_cpu = s->num_of_cpu < SNAPSHOT_MAX_CPU ? s->num_of_cpu : SNAPSHOT_MAX_CPU;
+    d->num_of_plugin = s->num_of_plugin < SNAPSHOT_MAX_PLUGIN ? s->num_of_plugin : SNAPSHOT_MAX_PLUGIN;
+    d->num_of_rsv = rts_taskset_get_size(s->taskset) + rts_taskset_get_size(&(s->members));
+    
+    for(c = 0; c < d->num_of_cpu; c++) {
+        d->free_utils[c] = s->sys_rt_free_utils[c];
+        d->curr_free_utils[c] = s->sys_rt_curr_free_utils[c];
+    }
+    
+    for(i = 0; i < d->num_of_plugin; i++) {
+        plg = &(s->plugin[i]);
+        used = 0;
+        
+        for(c = 0; c < plg->cpunum; c++)
+            used += plg->util_used_percpu[c];
+        
+        d->plugin_used_utils[i] = used;
+    }
+    
+    d->placement = s->placement;
+    d->admitted = s->admitted;
+    d->rejected = s->rejected;
+    d->overloaded = s->overloaded;
+    d->packing_efficiency = rts_scheduler_get_packing_efficiency(s);
+    
+    rts_snapshot_write_end(&(data->snap));
+    data->snap_dirty = 0;
+}
+
+static int rts_daemon_post_batch(struct rts_daemon* data, int cli_id, uint32_t nreq);
+
 void rts_daemon_handle_req(struct rts_daemon* data, int cli_id) {
     int sent;
-        
-    if(rts_daemon_check_for_fail(data, cli_id))
-        return;
     
-    if(!rts_daemon_check_for_update(data, cli_id))
-        return;
-       
-    sent = rts_daemon_process_req(data, cli_id);
+    // sockets are edge-triggered: keep serving until the client has no more pending requests
+    // or one of them is handed to the scheduler thread, whose completion resumes the drain
+    while(data->job_state[cli_id] == JOB_NONE) {
+        // the rest of a batch body comes before any further request,
+        // from a later EPOLLIN if it has not arrived yet
+        if(rts_carrier_batch_pending(&(data->chann), cli_id)) {
+            if(rts_daemon_check_for_fail(data, cli_id))
+                return;
+            
+            sent = rts_daemon_post_batch(data, cli_id, 0);
+            
+            if(sent == 0)
+                return;
+        }
+        else {
+            rts_carrier_recv(&(data->chann), cli_id);
+            
+            if(rts_daemon_check_for_fail(data, cli_id))
+                return;
 
-    if(sent <= 0)
-        rts_daemon_set_fail(data, cli_id);    
+            if(!rts_daemon_check_for_update(data, cli_id))
+                return;
+
+            sent = rts_daemon_process_req(data, cli_id);
+        }
+        
+        if(sent <= 0)
+            rts_daemon_set_fail(data, cli_id);
+    }
 }
 
-int rts_daemon_process_req(struct rts_daemon* data, int cli_id) {
+static struct rts_reply rts_daemon_dispatch_req(struct rts_daemon* data, pid_t ppid, struct rts_request* req) {
     struct rts_reply rep;
-    struct rts_request req;
-    struct rts_client* client;
     
-    client = rts_carrier_get_client(&(data->chann), cli_id);
-    req = rts_carrier_get_req(&(data->chann), cli_id);
+    if(req->req_type != RTS_CAP_QUERY && req->req_type != RTS_RSV_QUERY)
+        data->snap_dirty = 1;
     
-    switch(req.req_type) {
-        case RTS_CONNECTION:
-            rep = req_connection(data, cli_id, req.payload.ids.pid);
-            break;
+    switch(req->req_type) {
         case RTS_REFRESH_SYS:
             rep = req_refresh_sys(data);
             break;
         case RTS_REFRESH_SINGLE:
-            rep = req_refresh_single(data, req.payload.ids.rsvid);
+            rep = req_refresh_single(data, req->payload.ids.rsvid);
             break;
         case RTS_CAP_QUERY:
-            rep = req_cap_query(data, req.payload.query_type);
+            rep = req_cap_query(data, req->payload.query_type);
             break;
         case RTS_RSV_CREATE:
-            rep = req_rsv_create(data, &(req.payload.param), client->pid);
+            rep = req_rsv_create(data, &(req->payload.param), ppid);
+            break;
+        case RTS_RSV_CREATE_ATTACH:
+            rep = req_rsv_create_attach(data, &(req->payload.create_attach), ppid);
             break;
         case RTS_RSV_ATTACH:
-            rep = req_rsv_attach(data, req.payload.ids.rsvid, req.payload.ids.pid);
+            rep = req_rsv_attach(data, req->payload.ids.rsvid, req->payload.ids.pid);
             break;
         case RTS_RSV_DETACH:
-            rep = req_rsv_detach(data, req.payload.ids.rsvid);
+            rep = req_rsv_detach(data, req->payload.ids.rsvid);
             break;
         //case RTS_RSV_QUERY:
-            //rep = req_rsv_query(data, req.payload.ids.rsvid, req.payload.query_type);
+            //rep = req_rsv_query(data, req->payload.ids.rsvid, req->payload.query_type);
             //break;
         case RTS_RSV_DESTROY:
-            rep = req_rsv_destroy(data, req.payload.ids.rsvid);
+            rep = req_rsv_destroy(data, req->payload.ids.rsvid);
+            break;
+        default:
+            rep.rep_type = RTS_REQUEST_ERR;
+    }
+    
+    rts_scheduler_end_request(&(data->sched));
+    return rep;
+}
+
+// the estimator slot named by a creation is looked up in the table of the
+// client before the request leaves the I/O thread; an unknown slot is left
+// NULL and the creation is refused
+static void rts_daemon_bind_est(struct rts_daemon* data, int cli_id, struct rts_request* req) {
+    struct rts_params* p;
+    
+    if(req->req_type == RTS_RSV_CREATE)
+        p = &(req->payload.param);
+    else if(req->req_type == RTS_RSV_CREATE_ATTACH)
+        p = &(req->payload.create_attach.param);
+    else
+        return;
+    
+    p->estimatedp.value = rts_carrier_est_slot(&(data->chann), cli_id, p->estimatedp.slot);
+}
+
+static int rts_daemon_post_req(struct rts_daemon* data, int cli_id, struct rts_request* req) {
+    struct rts_job* job;
+    
+    job = rts_daemon_job_alloc(data, cli_id, JOB_REQUEST);
+    
+    if(job == NULL)
+        return -1;
+    
+    job->req = *req;
+    rts_daemon_bind_est(data, cli_id, &(job->req));
+    rts_daemon_job_post(data, job);
+    
+    return 1;
+}
+
+// 1 once the batch is posted, 0 while its body is still on its way
+static int rts_daemon_post_batch(struct rts_daemon* data, int cli_id, uint32_t nreq) {
+    int n;
+    struct rts_job* job;
+    
+    n = rts_carrier_recv_batch(&(data->chann), cli_id, nreq);
+    
+    if(n <= 0)
+        return n;
+    
+    nreq = n;
+    job = rts_daemon_job_alloc(data, cli_id, JOB_BATCH);
+    
+    if(job == NULL)
+        return -1;
+    
+    job->nreq = nreq;
+    job->batch = slab_alloc(&(data->batch_slab));
+    
+    if(job->batch == NULL) {
+        rts_daemon_job_free(data, job);
+        return -1;
+    }
+    
+    memcpy(job->batch->req, rts_carrier_get_batch(&(data->chann), cli_id), nreq * sizeof(struct rts_request));
+    
+    for(uint32_t i = 0; i < nreq; i++)
+        rts_daemon_bind_est(data, cli_id, &(job->batch->req[i]));
+    
+    rts_daemon_job_post(data, job);
+    
+    return 1;
+}
+
+int rts_daemon_process_req(struct rts_daemon* data, int cli_id) {
+    struct rts_reply rep;
+    struct rts_request req;
+    
+    req = rts_carrier_get_req(&(data->chann), cli_id);
+    
+    switch(req.req_type) {
+        case RTS_CONNECTION:
+            rep = req_connection(data, cli_id, req.payload.ids.pid);
+            break;
+        case RTS_RING_SETUP:
+            rep = req_ring_setup(data, cli_id);
+            break;
+        case RTS_EST_SETUP:
+            rep = req_est_setup(data, cli_id);
+            break;
+        case RTS_CAP_QUERY:
+            // answered from the snapshot, without waiting for admissions in progress
+            if(rts_snapshot_cap_query(&(data->snap), req.payload.query_type, &(rep.payload)) == 0) {
+                rep.rep_type = RTS_CAP_QUERY_OK;
+                break;
+            }
+            
+            return rts_daemon_post_req(data, cli_id, &req);
+        case RTS_BATCH:
+            LOG("Received BATCH REQ of %u requests.\n", req.payload.nreq);
+            return rts_daemon_post_batch(data, cli_id, req.payload.nreq) < 0 ? -1 : 1;
+        case RTS_REFRESH_SYS:
+        case RTS_REFRESH_SINGLE:
+        case RTS_RSV_CREATE:
+        case RTS_RSV_CREATE_ATTACH:
+        case RTS_RSV_ATTACH:
+        case RTS_RSV_DETACH:
+        case RTS_RSV_DESTROY:
+            if(rts_daemon_post_req(data, cli_id, &req) > 0)
+                return 1;
+            
+            rep.rep_type = RTS_REQUEST_ERR;
             break;
         default:
             rep.rep_type = RTS_REQUEST_ERR;
@@ -318,34 +780,103 @@ int rts_daemon_process_req(struct rts_daemon* data, int cli_id) {
     return rts_carrier_send(&(data->chann), &rep, cli_id);
 }
 
+static void rts_daemon_complete(struct rts_daemon* data) {
+    int sent;
+    int cli_id;
+    uint64_t v;
+    struct rts_job* job;
+    
+    // rearm the eventfd before draining, a later completion will ring it again
+    if(read(data->done_fd, &v, sizeof(uint64_t)) < 0 && errno != EAGAIN)
+        return;
+    
+    while((job = (struct rts_job*)jqueue_trypop(&(data->done))) != NULL) {
+        if(job->type == JOB_REEVAL) {
+            if(job->result > 0)
+                LOG("Re-evaluation updated %d threads.\n", job->result);
+            
+            data->reeval_pending = 0;
+            rts_daemon_job_free(data, job);
+            continue;
+        }
+        
+        cli_id = job->cli_id;
+        data->job_state[cli_id] = JOB_NONE;
+        
+        if(job->type == JOB_TEARDOWN) {
+            rts_carrier_rm_conn(&(data->chann), cli_id);
+            rts_daemon_job_free(data, job);
+            continue;
+        }
+        
+        if(job->type == JOB_BATCH)
+            sent = rts_carrier_send_batch(&(data->chann), job->batch->rep, job->nreq, cli_id);
+        else
+            sent = rts_carrier_send(&(data->chann), &(job->rep), cli_id);
+        
+        rts_daemon_job_free(data, job);
+        
+        if(sent <= 0)
+            rts_daemon_set_fail(data, cli_id);
+        
+        rts_daemon_handle_req(data, cli_id);
+    }
+}
+
 void rts_daemon_loop(struct rts_daemon* data) {
     int i;
+    int id;
+    int nready;
     
-    rts_carrier_prepare(&(data->chann));
+    if(rts_carrier_prepare(&(data->chann)) < 0 || rts_carrier_watch(&(data->chann), data->done_fd) < 0) {
+        LOG("Unable to prepare the carrier event loop.\n");
+        return;
+    }
 
-    while(1) {
+    while(!data->stop) {
 
-        rts_carrier_update(&(data->chann));
+        nready = rts_carrier_update(&(data->chann));
         
-        for(i = 0; i <= rts_carrier_get_conn(&(data->chann)); i++)
-            rts_daemon_handle_req(data, i);
+        // the timer interrupts the wait, see rts_daemon_reeval
+        if(data->reeval_due)
+            rts_daemon_post_reeval(data);
+        
+        for(i = 0; i < nready; i++) {
+            id = rts_carrier_get_ready(&(data->chann), i);
+            
+            if(id == data->done_fd)
+                rts_daemon_complete(data);
+            else
+                rts_daemon_handle_req(data, id);
+        }
+        
+        // retried on every wake-up, a completion frees a job
+        if(data->teardown_due)
+            rts_daemon_retry_teardown(data);
     }
 
     return;
 }
 
 void rts_daemon_destroy(struct rts_daemon* data) {
-    struct rts_task* t;
-        
-    while(1) {
-        t = rts_taskset_remove_top(&(data->tasks));
-        
-        if(t == NULL)
-            break;
-        
-        rts_task_destroy(t);
-    }
+    struct rts_job* job;
+    
+    // the scheduler thread serves the jobs already queued, then exits
+    jqueue_close(&(data->jobs));
+    pthread_join(data->sched_thread, NULL);
+    
+    while((job = (struct rts_job*)jqueue_trypop(&(data->done))) != NULL)
+        rts_daemon_job_free(data, job);
+    
+    jqueue_destroy(&(data->jobs));
+    jqueue_destroy(&(data->done));
+    close(data->done_fd);
+    slab_destroy(&(data->job_slab));
+    slab_destroy(&(data->batch_slab));
     
+    rts_snapshot_destroy(&(data->snap));
     restore_rt_kernel_limit(data->sched.sys_rt_runtime);
+    // releases the tasks still in the taskset
     rts_scheduler_destroy(&(data->sched));
+    rts_taskset_destroy(&(data->tasks));
 }
@@ -17,14 +17,76 @@
 #include "rts_taskset.h"
 #include "rts_channel.h"
 #include "rts_scheduler.h"
+#include "rts_snapshot.h"
+#include "../components/jqueue.h"
+#include "../components/slab.h"
+#include <pthread.h>
+#include <signal.h>
 
 #define PROC_RT_PERIOD_FILE "/proc/sys/kernel/sched_rt_period_us"
 #define PROC_RT_RUNTIME_FILE "/proc/sys/kernel/sched_rt_runtime_us"
+#define DAEMON_JOB_CHUNK 32     // jobs taken from the heap at once
+#define DAEMON_REEVAL_MS 500    // default period of the re-evaluation
 
+enum JOB_TYPE {
+    JOB_REQUEST,
+    JOB_BATCH,
+    JOB_TEARDOWN,
+    JOB_REEVAL                      // background re-evaluation, no client
+};
+
+// order in which the reservations created by a batch are admitted
+enum BATCH_ORDER {
+    BATCH_DECREASING,               // highest utilization first
+    BATCH_ARRIVAL
+};
+
+enum JOB_STATE {
+    JOB_NONE,
+    JOB_PENDING,
+    JOB_CLOSING
+};
+
+// work handed from the I/O thread to the scheduler thread and back
+struct rts_job {
+    struct jqueue_node node;        // must stay first
+    enum JOB_TYPE type;
+    int cli_id;
+    pid_t pid;
+    struct rts_request req;
+    struct rts_reply rep;
+    uint32_t nreq;
+    struct rts_job_batch* batch;    // JOB_BATCH only
+    int result;                     // JOB_REEVAL: threads updated
+};
+
+// requests of a batch and their replies, slot by slot
+struct rts_job_batch {
+    struct rts_request req[CHANNEL_BATCH_MAX];
+    struct rts_reply rep[CHANNEL_BATCH_MAX];
+};
+
+// chann and job_state belong to the I/O thread (rts_daemon_loop),
+// sched, tasks and the snapshot writer to the scheduler thread
 struct rts_daemon {
     struct rts_carrier chann;
     struct rts_scheduler sched;
     struct rts_taskset tasks;
+    struct rts_snapshot snap;
+    int snap_dirty;
+    enum BATCH_ORDER batch_order;
+    struct jqueue jobs;
+    struct jqueue done;
+    struct slab job_slab;           // jobs and batches, I/O thread only
+    struct slab batch_slab;
+    int done_fd;
+    pthread_t sched_thread;
+    volatile sig_atomic_t stop;
+    volatile sig_atomic_t reeval_due;   // set by the timer signal
+    int reeval_pending;             // a JOB_REEVAL is in flight
+    long reeval_period;             // [ms], 0 if disabled
+    int teardown_due;               // a failed client waits for its teardown job
+    char job_state[CHANNEL_MAX_SIZE];
 };
 
 int rts_daemon_init(struct rts_daemon* data);
@@ -35,6 +97,13 @@ void rts_daemon_register_sig_int(void (*func)(int));
 
 void rts_daemon_register_sig_alarm(void (*func)(int));
 
+void rts_daemon_stop(struct rts_daemon* data);
+
+// asks for a background re-evaluation, safe from a signal handler
+void rts_daemon_reeval(struct rts_daemon* data);
+
+void rts_daemon_publish(struct rts_daemon* data);
+
 void rts_daemon_handle_req(struct rts_daemon* data, int cli_id);
 
 int rts_daemon_process_req(struct rts_daemon* data, int cli_id);
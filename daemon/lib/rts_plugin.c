@@ -12,6 +12,7 @@ static const char *plugin_str[] = {
     "DM",
     "FP",
     "RR",
+    "GEDF",
     "CUSTOM"
 };
 
@@ -76,7 +77,6 @@ static int load_libraries(struct rts_plugin* plg, int num_of_plugin) {
         plg[i].util_used_percpu = calloc(cpunum, sizeof(float));        
         plg[i].pluginid = i;
         
-        plg[i].ts_recalc_utils = dlsym(dl_ptr, TS_RECALC_UTILS_FUN);
         plg[i].ts_recalc_prios = dlsym(dl_ptr, ts_recalc_prios_FUN);
         plg[i].t_schedule = dlsym(dl_ptr, T_SCHEDULE_FUN);
         plg[i].t_deschedule = dlsym(dl_ptr, T_DESCHEDULE_FUN);
@@ -85,6 +85,14 @@ static int load_libraries(struct rts_plugin* plg, int num_of_plugin) {
         plg[i].t_remove_from_utils = dlsym(dl_ptr, T_REMOVE_FROM_UTILS_FUN);
         plg[i].t_calc_prio = dlsym(dl_ptr, T_CALC_PRIO_FUN);
         plg[i].t_test = dlsym(dl_ptr, T_TEST_FUN);
+        plg[i].t_test_cpu = dlsym(dl_ptr, T_TEST_CPU_FUN);
+        plg[i].t_test_split = dlsym(dl_ptr, T_TEST_SPLIT_FUN);
+        plg[i].t_cpu_share = dlsym(dl_ptr, T_CPU_SHARE_FUN);
+        plg[i].init = dlsym(dl_ptr, PLUGIN_INIT_FUN);
+        plg[i].destroy = dlsym(dl_ptr, PLUGIN_DESTROY_FUN);
+        
+        if(plg[i].init != NULL && plg[i].init(&(plg[i])) < 0)
+            return -1;
     }
     
     return 0;
@@ -114,6 +122,9 @@ int rts_plugins_init(struct rts_plugin** plgs, int* plgnum) {
 
 void rts_plugins_destroy(struct rts_plugin* plgs, int plgnum) {    
     for(int i = 0; i < plgnum; i++) {
+        if(plgs[i].destroy != NULL)
+            plgs[i].destroy(&(plgs[i]));
+        
         free(plgs[i].util_used_percpu);
         dlclose(plgs[i].dl_ptr);
     }
@@ -20,7 +20,6 @@
 #define PLUGIN_CFG              "plugin/schedconfig.cfg"
 #define PLUGIN_PREFIX           "plugin/sched_"
 
-#define TS_RECALC_UTILS_FUN     "ts_recalc_utils"
 #define ts_recalc_prios_FUN     "ts_recalc_prios"
 
 #define T_SCHEDULE_FUN          "t_schedule"
@@ -31,7 +30,13 @@
 #define T_RECALC_UTIL_FUN       "t_recalc_util"
 
 #define T_TEST_FUN              "t_test"
+#define T_TEST_CPU_FUN          "t_test_cpu"
+#define T_TEST_SPLIT_FUN        "t_test_split"
 #define T_CALC_PRIO_FUN         "t_calc_prio"
+#define T_CPU_SHARE_FUN         "t_cpu_share"
+
+#define PLUGIN_INIT_FUN         "plugin_init"
+#define PLUGIN_DESTROY_FUN      "plugin_destroy"
 
 enum plugin {
     NONE,
@@ -40,6 +45,7 @@ enum plugin {
     DM,
     FP,
     RR,
+    GEDF,
     CUSTOM,
     NUM_OF_SCHED
 };
@@ -55,6 +61,7 @@ enum plugin {
 
 struct rts_task;
 struct rts_taskset;
+struct arena;
 
 struct rts_plugin {
     void* dl_ptr;
@@ -64,10 +71,13 @@ struct rts_plugin {
     int pluginid;
     int cpunum;
     float* util_used_percpu;
+    float cpu_capacity;         // utilization a cpu offers to the plugins
+    void* priv;                 // plugin private data, released by destroy
+    struct arena* scratch;      // temporaries of the current request, owned by
+                                // the scheduler thread (not for t_test_cpu)
     
     enum plugin type;
     
-    int (*ts_recalc_utils)(struct rts_plugin* this, struct rts_taskset* ts);
     void (*ts_recalc_prios)(struct rts_plugin* this, struct rts_taskset* ts);
     
     int (*t_schedule)(struct rts_task* t);
@@ -82,9 +92,35 @@ struct rts_plugin {
                     struct rts_task* t, 
                     float* free_utils);
     
+    // optional: same test restricted to one cpu, must not modify t.
+    // Calls for different cpus may run concurrently.
+    float (*t_test_cpu)(struct rts_plugin* this, 
+                        struct rts_taskset* ts, 
+                        struct rts_task* t, 
+                        int cpu,
+                        float* free_utils);
+    
+    // optional: test of t split over several cpus, tried when no plugin
+    // holds it on a single one. On success fills t->nsplit, t->split_cpu
+    // and t->split_frac (t->split_cpu[0] is the cpu it starts on).
+    float (*t_test_split)(struct rts_plugin* this, 
+                          struct rts_taskset* ts, 
+                          struct rts_task* t, 
+                          float* free_utils);
+    
     void (*t_calc_prio)(struct rts_plugin* this, 
                         struct rts_taskset* ts, 
                         struct rts_task* t);
+    
+    // optional: fraction of the utilization of t charged to cpu, for
+    // plugins spreading a task over several cpus. Without it the whole
+    // utilization is charged to t->cpu.
+    float (*t_cpu_share)(struct rts_plugin* this, 
+                         struct rts_task* t, 
+                         int cpu);
+    
+    int (*init)(struct rts_plugin* this);       // optional
+    void (*destroy)(struct rts_plugin* this);   // optional
 
 };
 
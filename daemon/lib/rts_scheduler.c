@@ -2,74 +2,409 @@
 #include "rts_taskset.h"
 #include "rts_task.h"
 #include "rts_plugin.h"
+#include "rts_utils.h"
+#include "../components/prm.h"
 #include <sys/sysinfo.h>
 #include <stdlib.h>
 #include <string.h>
 
-static int rts_scheduler_mem_attach(struct shatomic* mem) {
-    key_t key = shatomic_getkey(mem);
-   
-    shatomic_init(mem);
-            
-    if(shatomic_use(mem, key, mem->nvalue) < 0)
-        return -1;
+static const char* placement_str[] = {
+    "FIRST_FIT",
+    "BEST_FIT",
+    "WORST_FIT",
+    "NEXT_FIT"
+};
+
+static const char* controller_str[] = {
+    "OFF",
+    "QUANTILE",
+    "PI"
+};
+
+static int64_t rts_scheduler_util_fix(float util) {
+    return (int64_t)(util * (double)SCHED_UTIL_ONE + 0.5);
+}
+
+// utilization of t charged to each cpu: a task spread over several cpus is
+// charged to each of them for its share
+static void rts_scheduler_charges(struct rts_scheduler* s, struct rts_task* t, int64_t* charge) {
+    struct rts_plugin* plg = &(s->plugin[t->pluginid]);
     
-    if(shatomic_attach(mem) < 0)
-        return -1;
+    memset(charge, 0, s->num_of_cpu * sizeof(int64_t));
     
-    return 0;
+    if(plg->t_cpu_share == NULL) {
+        charge[t->cpu] = rts_scheduler_util_fix(rts_task_get_util(t));
+        return;
+    }
+    
+    for(int i = 0; i < s->num_of_cpu; i++)
+        charge[i] = rts_scheduler_util_fix(rts_task_get_util(t) * plg->t_cpu_share(plg, t, i));
 }
 
-static void rts_scheduler_mem_detach(struct shatomic* mem) {
-    shatomic_detach(mem);
+// the sums are exact, the float views of the plugin and of the free
+// utilization follow them; the overload flag of cpu flips as its sum
+// crosses 1
+static void rts_scheduler_load(struct rts_scheduler* s, int pluginid, int cpu, int64_t delta) {
+    int over;
+    int64_t* plg_load = &(s->plugin_load[pluginid * s->num_of_cpu + cpu]);
+    
+    *plg_load += delta;
+    s->cpu_load[cpu] += delta;
+    
+    s->plugin[pluginid].util_used_percpu[cpu] = *plg_load / (float)SCHED_UTIL_ONE;
+    s->sys_rt_curr_free_utils[cpu] = s->sys_rt_free_utils[cpu] - s->cpu_load[cpu] / (float)SCHED_UTIL_ONE;
+    
+    over = s->cpu_load[cpu] > SCHED_UTIL_ONE;
+    
+    if(over != s->cpu_overloaded[cpu]) {
+        s->cpu_overloaded[cpu] = over;
+        s->overloaded += over ? 1 : -1;
+    }
 }
 
+static void rts_scheduler_charge_utils(struct rts_scheduler* s, struct rts_task* t, int sign) {
+    rts_scheduler_charges(s, t, s->charge_tmp);
+    
+    for(int i = 0; i < s->num_of_cpu; i++)
+        if(s->charge_tmp[i] != 0)
+            rts_scheduler_load(s, t->pluginid, i, sign * s->charge_tmp[i]);
+}
+
+// called after the plugin hooks, so that the plugin view is resynced
 static void rts_scheduler_add_utils(struct rts_scheduler* s, struct rts_task* t) {
-    s->sys_rt_curr_free_utils[t->cpu] -= rts_task_get_util(t);
+    rts_scheduler_charge_utils(s, t, 1);
 }
 
 static void rts_scheduler_remove_utils(struct rts_scheduler* s, struct rts_task* t) {
-    s->sys_rt_curr_free_utils[t->cpu] += rts_task_get_util(t);
+    rts_scheduler_charge_utils(s, t, -1);
+}
+
+// generation of the estimates of t
+static uint32_t rts_scheduler_est_gen(struct rts_task* t) {
+    return rts_task_get_est_param(t, EST_GEN);
+}
+
+// a task with wcet and period of its own never changes, the others change
+// when their client bumps the generation of the estimates
+static int rts_scheduler_est_changed(struct rts_task* t) {
+    if(t->wcet != 0 && t->period != 0)
+        return 0;
+    
+    return rts_scheduler_est_gen(t) != t->est_gen;
+}
+
+struct rts_scheduler_test {
+    struct rts_scheduler* s;
+    struct rts_task* t;
+};
+
+static void rts_scheduler_test_one(void* arg, int i) {
+    struct rts_scheduler_test* job = arg;
+    struct rts_scheduler* s = job->s;
+    struct rts_plugin* plg = &(s->plugin[i / s->num_of_cpu]);
+    int cpu = i % s->num_of_cpu;
+    
+    if(plg->t_test_cpu == NULL)
+        return;
+    
+    s->test_scores[i] = plg->t_test_cpu(plg, s->taskset, job->t, cpu, s->sys_rt_curr_free_utils);
+}
+
+// Fill test_scores with every (plugin, cpu) test, in parallel when worth it.
+// Plugins without t_test_cpu are tested as a whole on this thread.
+static void rts_scheduler_test_all(struct rts_scheduler* s, struct rts_task* t) {
+    int ntest;
+    float score;
+    struct rts_plugin* plg;
+    struct rts_scheduler_test job = { s, t };
+    
+    ntest = s->num_of_plugin * s->num_of_cpu;
+    memset(s->test_scores, 0, ntest * sizeof(float));
+    
+    if(ntest >= SCHED_PARALLEL_MIN)
+        workpool_run(&(s->pool), ntest, rts_scheduler_test_one, &job);
+    else
+        for(int i = 0; i < ntest; i++)
+            rts_scheduler_test_one(&job, i);
+    
+    for(int p = 0; p < s->num_of_plugin; p++) {
+        plg = &(s->plugin[p]);
+        
+        if(plg->t_test_cpu != NULL)
+            continue;
+        
+        score = plg->t_test(plg, s->taskset, t, s->sys_rt_curr_free_utils);
+        
+        if(score > 0)
+            s->test_scores[p * s->num_of_cpu + t->cpu] = score;
+    }
+}
+
+// pick a cpu among those where plugin plg reached score, following the policy
+static int rts_scheduler_place(struct rts_scheduler* s, int plg, float score) {
+    int c;
+    int best = -1;
+    float* sc = &(s->test_scores[plg * s->num_of_cpu]);
+    float* free_utils = s->sys_rt_curr_free_utils;
+    
+    switch(s->placement) {
+        case PLACE_BEST_FIT:
+            for(c = 0; c < s->num_of_cpu; c++)
+                if(sc[c] == score && (best == -1 || free_utils[c] < free_utils[best]))
+                    best = c;
+            break;
+        case PLACE_WORST_FIT:
+            for(c = 0; c < s->num_of_cpu; c++)
+                if(sc[c] == score && (best == -1 || free_utils[c] > free_utils[best]))
+                    best = c;
+            break;
+        case PLACE_NEXT_FIT:
+            for(int k = 0; k < s->num_of_cpu && best == -1; k++) {
+                c = (s->next_fit_cpu + k) % s->num_of_cpu;
+                
+                if(sc[c] == score)
+                    best = c;
+            }
+            
+            s->next_fit_cpu = best;
+            break;
+        default:
+            for(c = 0; c < s->num_of_cpu && best == -1; c++)
+                if(sc[c] == score)
+                    best = c;
+    }
+    
+    return best;
+}
+
+// no plugin holds t on a single cpu: the first one able to split it wins
+static int rts_scheduler_split(struct rts_scheduler* s, struct rts_task* t) {
+    struct rts_plugin* plg;
+    
+    for(int p = 0; p < s->num_of_plugin; p++) {
+        plg = &(s->plugin[p]);
+        t->nsplit = 0;
+        
+        if(plg->t_test_split != NULL && plg->t_test_split(plg, s->taskset, t, s->sys_rt_curr_free_utils) > 0)
+            return p;
+    }
+    
+    t->nsplit = 0;
+    return -1;
+}
+
+// the thread moves itself between the pieces (see rts_rsv_begin)
+static void rts_scheduler_publish_split(struct rts_scheduler* s, struct rts_task* t) {
+    atomic_t* est = t->est_param.value;
+    
+    for(uint32_t k = 0; k < t->nsplit; k++) {
+        atomic_set(&(est[EST_SPLIT_CPU(k)]), t->split_cpu[k]);
+        atomic_set(&(est[EST_SPLIT_RUNTIME(k)]), t->split_runtime[k]);
+        atomic_set(&(est[EST_SPLIT_DEADLINE(k)]), t->split_deadline[k]);
+    }
+    
+    atomic_set(&(est[EST_SPLIT_PERIOD]), t->period);
+    atomic_set_release(&(est[EST_SPLIT_NUM]), t->nsplit);
 }
 
 static int rts_scheduler_assign(struct rts_scheduler* s, struct rts_task* t) {
     int best_cpu;
     int best_plg;
-    int curr_plg;
     float best_test;
     float curr_test;
     
     best_plg = -1;
     best_test = 0;
     
-    for(curr_plg = 0; curr_plg < s->num_of_plugin; curr_plg++) {
-        
-        curr_test = s->plugin[curr_plg].t_test(&(s->plugin[curr_plg]), 
-                    s->taskset, t, s->sys_rt_curr_free_utils);
-        
-        if(curr_test > best_test) {
-            best_test = curr_test;
-            best_plg = curr_plg;
-            best_cpu = t->cpu;
+    rts_scheduler_test_all(s, t);
+    
+    // the members of a group are deadline threads on its cpu
+    if(t->members != NULL)
+        for(int p = 0; p < s->num_of_plugin; p++)
+            if(s->plugin[p].type != EDF)
+                memset(&(s->test_scores[p * s->num_of_cpu]), 0, s->num_of_cpu * sizeof(float));
+    
+    // best score wins, ties go to the lower plugin index
+    for(int p = 0; p < s->num_of_plugin; p++) {
+        for(int c = 0; c < s->num_of_cpu; c++) {
+            curr_test = s->test_scores[p * s->num_of_cpu + c];
+            
+            if(curr_test > best_test) {
+                best_test = curr_test;
+                best_plg = p;
+            }
         }
-        
     }
     
-    if(best_plg == -1)
+    if(best_plg != -1)
+        best_cpu = rts_scheduler_place(s, best_plg, best_test);
+    else if(s->split_tasks && t->members == NULL && (best_plg = rts_scheduler_split(s, t)) != -1)
+        best_cpu = t->split_cpu[0];
+    else {
+        s->rejected++;
         return -1;
+    }
     
     t->cpu = best_cpu;
     t->pluginid = best_plg;
-    rts_taskset_add_top(s->taskset, t);
+    
+    if(rts_taskset_add_top(s->taskset, t) < 0) {
+        t->nsplit = 0;
+        s->rejected++;
+        return -1;
+    }
+    
+    s->admitted++;
     
     s->plugin[best_plg].t_calc_prio(&(s->plugin[best_plg]), s->taskset, t);
     s->plugin[best_plg].t_add_to_utils(&(s->plugin[best_plg]), t);
     
     rts_scheduler_add_utils(s, t);
     
+    if(t->nsplit > 0)
+        rts_scheduler_publish_split(s, t);
+    
+    return 0;
+}
+
+static void rts_scheduler_unassign(struct rts_scheduler* s, struct rts_task* t) {
+    rts_taskset_remove_by_rsvid(s->taskset, t->id);
+    s->plugin[t->pluginid].t_remove_from_utils(&(s->plugin[t->pluginid]), t);
+    rts_scheduler_remove_utils(s, t);
+}
+
+static struct rts_task* rts_scheduler_task_create(struct rts_scheduler* s, struct rts_params* tp, pid_t ppid) {
+    struct rts_task* t;
+    
+    // the slot was resolved in the table of the client when the request arrived
+    if(tp->estimatedp.value == NULL)
+        return NULL;
+    
+    t = slab_alloc(&(s->task_slab));
+    
+    if(t == NULL)
+        return NULL;
+    
+    rts_task_setup(t, 0, tp->clk);
+    t->id = ++s->next_rsv_id;
+    t->ptid = ppid;
+    t->period = tp->period;
+    t->wcet = tp->budget;
+    t->deadline = tp->deadline;
+    t->priority = tp->priority;
+    t->flags = tp->flags;
+    t->est_param = tp->estimatedp;
+    
+    if(rts_task_est_load(t, s->wcet_quantile, s->wcet_margin) < 0) {
+        slab_free(&(s->task_slab), t);
+        return NULL;
+    }
+    
+    // the interface of a group is a periodic resource: deadline = period
+    if(t->flags & RTS_RSV_GROUP) {
+        t->members = malloc(sizeof(struct rts_taskset));
+        
+        if(t->members == NULL || t->wcet == 0 || t->period == 0 || tp->group != 0) {
+            free(t->members);
+            slab_free(&(s->task_slab), t);
+            return NULL;
+        }
+        
+        t->deadline = t->period;
+        rts_taskset_init(t->members);
+    }
+    
+    t->overrun_seen = rts_task_get_est_param(t, EST_OVERRUN);
+    rts_task_update_util(t);
+    
+    return t;
+}
+
+static void rts_scheduler_task_release(struct rts_scheduler* s, struct rts_task* t) {
+    if(t->members != NULL) {
+        rts_taskset_destroy(t->members);
+        free(t->members);
+    }
+    
+    slab_free(&(s->task_slab), t);
+}
+
+// admits t inside the group gid of the same client: the members, t
+// included, must meet their deadlines on the supply of the periodic
+// resource of the group. The node is not tested again, the group already
+// holds the bandwidth; the members keep the budgets they were admitted with.
+static int rts_scheduler_admit_member(struct rts_scheduler* s, struct rts_task* t, rsv_t gid) {
+    struct rts_task* g = rts_taskset_search(s->taskset, gid);
+    struct rts_taskset* ms;
+    struct prm_task* set;
+    int n;
+    
+    if(g == NULL || g->members == NULL || g->ptid != t->ptid || t->members != NULL || t->wcet == 0 || t->period == 0) {
+        s->rejected++;
+        return -1;
+    }
+    
+    ms = g->members;
+    n = rts_taskset_get_size(ms);
+    set = arena_alloc(&(s->scratch), (n + 1) * sizeof(struct prm_task));
+    
+    if(set == NULL) {
+        s->rejected++;
+        return -1;
+    }
+    
+    for(int i = 0; i < n; i++) {
+        set[i].wcet = ms->wcet[i];
+        set[i].period = ms->period[i];
+        set[i].deadline = ms->deadline[i] != 0 && ms->deadline[i] < ms->period[i] ? ms->deadline[i] : ms->period[i];
+    }
+    
+    set[n].wcet = t->wcet;
+    set[n].period = t->period;
+    set[n].deadline = t->deadline != 0 && t->deadline < t->period ? t->deadline : t->period;
+    
+    if(!prm_edf_test(set, n + 1, g->period, g->wcet)) {
+        s->rejected++;
+        return -1;
+    }
+    
+    t->group = g;
+    t->cpu = g->cpu;
+    t->pluginid = g->pluginid;
+    
+    if(rts_taskset_add_top(ms, t) < 0) {
+        s->rejected++;
+        return -1;
+    }
+    
+    if(rts_taskset_add_top(&(s->members), t) < 0) {
+        rts_taskset_remove_by_rsvid(ms, t->id);
+        s->rejected++;
+        return -1;
+    }
+    
+    s->admitted++;
     return 0;
 }
 
+static int rts_scheduler_admit(struct rts_scheduler* s, struct rts_task* t, struct rts_params* tp) {
+    if(tp->group != 0)
+        return rts_scheduler_admit_member(s, t, tp->group);
+    
+    return rts_scheduler_assign(s, t);
+}
+
+// undoes rts_scheduler_admit
+static void rts_scheduler_dismiss(struct rts_scheduler* s, struct rts_task* t) {
+    if(t->group == NULL) {
+        rts_scheduler_unassign(s, t);
+        return;
+    }
+    
+    rts_taskset_remove_by_rsvid(t->group->members, t->id);
+    rts_taskset_remove_by_rsvid(&(s->members), t->id);
+}
+
 static int rts_scheduler_schedule(struct rts_scheduler* s, struct rts_task* t) {
     return s->plugin[t->pluginid].t_schedule(t);
 }
@@ -78,10 +413,16 @@ static int rts_scheduler_deschedule(struct rts_scheduler* s, struct rts_task* t)
     return s->plugin[t->pluginid].t_deschedule(t);
 }
 
+// the client of a split task could not move its thread to a piece
+static int rts_scheduler_split_failed(struct rts_task* t) {
+    return t->nsplit != 0 && rts_task_get_est_param(t, EST_SPLIT_FAIL) != 0;
+}
+
 // PUBLIC
 
 void rts_scheduler_init(struct rts_scheduler* s, struct rts_taskset* ts, int rt_period, int rt_runtime) {
     int i;
+    int nworkers;
     float sys_rt_util;
     
     s->sys_rt_period = rt_period;
@@ -102,55 +443,409 @@ void rts_scheduler_init(struct rts_scheduler* s, struct rts_taskset* ts, int rt_
     }
     
     s->taskset = ts;
+    rts_taskset_init(&(s->members));
     s->next_rsv_id = 0;
+    slab_init(&(s->task_slab), sizeof(struct rts_task), SCHED_TASK_CHUNK);
+    arena_init(&(s->scratch), SCHED_SCRATCH_SIZE);
     rts_plugins_init(&(s->plugin), &(s->num_of_plugin));
+    
+    for(i = 0; i < s->num_of_plugin; i++) {
+        s->plugin[i].scratch = &(s->scratch);
+        s->plugin[i].cpu_capacity = sys_rt_util;
+    }
+    
+    rts_config_load(&(s->config), PLUGIN_CFG);
+    s->placement = PLACE_FIRST_FIT;
+    s->next_fit_cpu = 0;
+    s->admitted = 0;
+    s->rejected = 0;
+    
+    for(i = 0; i < NUM_OF_PLACEMENT; i++)
+        if(!strcmp(rts_config_get_str(&(s->config), "placement", ""), placement_str[i]))
+            s->placement = (enum PLACEMENT)i;
+    
+    s->split_tasks = !strcmp(rts_config_get_str(&(s->config), "split_tasks", "OFF"), "ON");
+    s->wcet_quantile = rts_config_get_double(&(s->config), "wcet_percentile", SCHED_WCET_PERCENTILE) / 100;
+    s->wcet_margin = rts_config_get_double(&(s->config), "wcet_margin", SCHED_WCET_MARGIN) / 100;
+    
+    if(s->wcet_quantile <= 0 || s->wcet_quantile > 1)
+        s->wcet_quantile = SCHED_WCET_PERCENTILE / 100;
+    
+    if(s->wcet_margin < 0)
+        s->wcet_margin = 0;
+    
+    s->overrun_grow = rts_config_get_long(&(s->config), "overrun_grow", SCHED_OVERRUN_GROW);
+    s->overrun_growth = rts_config_get_double(&(s->config), "overrun_growth", SCHED_OVERRUN_GROWTH) / 100;
+    s->controller = CTL_OFF;
+    
+    for(i = 0; i < NUM_OF_CONTROLLER; i++)
+        if(!strcmp(rts_config_get_str(&(s->config), "controller", ""), controller_str[i]))
+            s->controller = (enum CONTROLLER)i;
+    
+    s->ctl_gain = rts_config_get_double(&(s->config), "controller_gain", SCHED_CTL_GAIN) / 100;
+    s->ctl_miss = rts_config_get_double(&(s->config), "controller_miss", SCHED_CTL_MISS) / 100;
+    s->ctl_kp = rts_config_get_double(&(s->config), "controller_kp", SCHED_CTL_KP);
+    s->ctl_ki = rts_config_get_double(&(s->config), "controller_ki", SCHED_CTL_KI);
+    
+    if(s->ctl_gain < 0 || s->ctl_gain > 1)
+        s->ctl_gain = SCHED_CTL_GAIN / 100;
+    
+    s->test_scores = calloc(s->num_of_plugin * s->num_of_cpu, sizeof(float));
+    s->cpu_load = calloc(s->num_of_cpu, sizeof(int64_t));
+    s->plugin_load = calloc(s->num_of_plugin * s->num_of_cpu, sizeof(int64_t));
+    s->charge_tmp = calloc(2 * s->num_of_cpu, sizeof(int64_t));
+    s->cpu_overloaded = calloc(s->num_of_cpu, sizeof(char));
+    s->plugin_dirty = calloc(s->num_of_plugin, sizeof(char));
+    s->overloaded = 0;
+    
+    // the scheduler thread takes part in each round
+    nworkers = s->num_of_cpu - 1 < SCHED_POOL_MAX ? s->num_of_cpu - 1 : SCHED_POOL_MAX;
+    workpool_init(&(s->pool), nworkers);
 }
 
 void rts_scheduler_destroy(struct rts_scheduler* s) {
+    struct rts_task* t;
+    
+    // tasks live in the slab: hand them back before it goes away
+    while((t = rts_taskset_remove_top(&(s->members))) != NULL)
+        rts_scheduler_task_release(s, t);
+    
+    while((t = rts_taskset_remove_top(s->taskset)) != NULL)
+        rts_scheduler_task_release(s, t);
+    
+    rts_taskset_destroy(&(s->members));
+    
+    workpool_destroy(&(s->pool));
+    free(s->test_scores);
+    free(s->cpu_load);
+    free(s->plugin_load);
+    free(s->charge_tmp);
+    free(s->cpu_overloaded);
+    free(s->plugin_dirty);
     free(s->sys_rt_free_utils);
     free(s->sys_rt_curr_free_utils);
     rts_plugins_destroy(s->plugin, s->num_of_plugin);
+    slab_destroy(&(s->task_slab));
+    arena_destroy(&(s->scratch));
+}
+
+void rts_scheduler_end_request(struct rts_scheduler* s) {
+    arena_reset(&(s->scratch));
 }
 
 void rts_scheduler_delete(struct rts_scheduler* s, pid_t ppid) {   
     struct rts_task* t;
     
+    // members first: their groups go with the other tasks of the client
+    while((t = rts_taskset_remove_by_ppid(&(s->members), ppid)) != NULL) {
+        rts_taskset_remove_by_rsvid(t->group->members, t->id);
+        rts_scheduler_task_release(s, t);
+    }
+    
     while(1) {
         t = rts_taskset_remove_by_ppid(s->taskset, ppid);
         
         if(t == NULL)
             break;
         
-        rts_scheduler_remove_utils(s, t);
         s->plugin[t->pluginid].t_remove_from_utils(&(s->plugin[t->pluginid]), t);
+        rts_scheduler_remove_utils(s, t);
         
-        rts_scheduler_mem_detach(&(t->est_param));
-        rts_task_destroy(t);
+        rts_scheduler_task_release(s, t);
     }
 }
 
+// only the tasks whose estimates moved are visited by the plugins, the
+// sums are kept up to date by deltas. Finding them still reads the
+// generation of every task: a client bumps it in its table, and cannot
+// tell the daemon without a request.
 int rts_scheduler_refresh_utils(struct rts_scheduler* s) {
-    int cpus_overl = 0;
+    int plg_overl = 0;
+    iterator_t iterator;
+    struct rts_task* t;
+    
+    iterator = rts_taskset_iterator_init(s->taskset);
     
-    for(int i = 0; i < s->num_of_plugin; i++)
-        cpus_overl -= s->plugin[i].ts_recalc_utils(&(s->plugin[i]), s->taskset);
+    for(; iterator != NULL; iterator = rts_taskset_iterator_get_next(iterator)) {
+        t = rts_taskset_iterator_get_elem(iterator);
+        
+        if(rts_scheduler_est_changed(t) && rts_scheduler_refresh_util(s, t) < 0)
+            plg_overl = 1;
+    }
     
-    return cpus_overl;
+    if(s->overloaded > 0)
+        return -(int)s->overloaded;
+    
+    return -plg_overl;
 }
 
 void rts_scheduler_refresh_prios(struct rts_scheduler* s) {
-    for(int i = 0; i < s->num_of_plugin; i++)
+    for(int i = 0; i < s->num_of_plugin; i++) {
+        if(!s->plugin_dirty[i])
+            continue;
+        
         s->plugin[i].ts_recalc_prios(&(s->plugin[i]), s->taskset);
+        s->plugin_dirty[i] = 0;
+    }
 }
 
 int rts_scheduler_refresh_util(struct rts_scheduler* s, struct rts_task* t) {
-    return s->plugin[t->pluginid].t_recalc_util(&(s->plugin[t->pluginid]), t);
+    int ret;
+    int64_t* before = s->charge_tmp;
+    int64_t* after = s->charge_tmp + s->num_of_cpu;
+    struct rts_plugin* plg = &(s->plugin[t->pluginid]);
+    
+    // read first: an update landing meanwhile is seen by the next refresh
+    rts_task_est_load(t, s->wcet_quantile, s->wcet_margin);
+    
+    rts_scheduler_charges(s, t, before);
+    ret = plg->t_recalc_util(plg, t);
+    rts_scheduler_charges(s, t, after);
+    
+    for(int i = 0; i < s->num_of_cpu; i++)
+        if(before[i] != 0 || after[i] != 0)
+            rts_scheduler_load(s, t->pluginid, i, after[i] - before[i]);
+    
+    rts_taskset_update(s->taskset, t);
+    s->plugin_dirty[t->pluginid] = 1;
+    
+    return ret < 0 || s->cpu_overloaded[t->cpu] ? -1 : 0;
 }
 
 void rts_scheduler_refresh_prio(struct rts_scheduler* s, struct rts_task* t) {    
     s->plugin[t->pluginid].t_calc_prio(&(s->plugin[t->pluginid]), s->taskset, t);
 }
 
+// the budget of t can go up to its deadline, or its period
+static uint64_t rts_scheduler_budget_limit(struct rts_task* t) {
+    return rts_task_get_deadline(t) != 0 ? rts_task_get_deadline(t) : rts_task_get_period(t);
+}
+
+// sets the budget of t if the utilization of the plugin and of the cpu
+// stay within bounds, the previous one is restored otherwise; returns 1 if
+// it changed. Growing budgets go through rts_scheduler_grow.
+static int rts_scheduler_resize(struct rts_scheduler* s, struct rts_task* t, uint64_t budget) {
+    uint64_t wcet = t->wcet;
+    
+    if(budget == wcet)
+        return 0;
+    
+    t->wcet = budget;
+    
+    if(rts_scheduler_refresh_util(s, t) < 0) {
+        t->wcet = wcet;
+        rts_scheduler_refresh_util(s, t);
+        return 0;
+    }
+    
+    return 1;
+}
+
+// can the plugin of t admit it again, with the budget, on the cpu it runs
+// on: t is taken out of its partition and of the loads for the test, as
+// at its admission. A plugin without a per-cpu test is only bound by the
+// utilization checked when the budget is set.
+static int rts_scheduler_fits(struct rts_scheduler* s, struct rts_task* t, uint64_t budget) {
+    struct rts_plugin* plg = &(s->plugin[t->pluginid]);
+    uint64_t wcet = t->wcet;
+    float score;
+    
+    if(plg->t_test_cpu == NULL)
+        return 1;
+    
+    plg->t_remove_from_utils(plg, t);
+    rts_scheduler_remove_utils(s, t);
+    rts_taskset_part_leave(s->taskset, t);
+    
+    t->wcet = budget;
+    rts_task_update_util(t);
+    score = plg->t_test_cpu(plg, s->taskset, t, t->cpu, s->sys_rt_curr_free_utils);
+    t->wcet = wcet;
+    rts_task_update_util(t);
+    
+    rts_taskset_update(s->taskset, t);
+    plg->t_add_to_utils(plg, t);
+    rts_scheduler_add_utils(s, t);
+    
+    return score > 0;
+}
+
+// a larger budget is set only if the plugin admits it
+static int rts_scheduler_grow(struct rts_scheduler* s, struct rts_task* t, uint64_t budget) {
+    if(budget <= t->wcet || !rts_scheduler_fits(s, t, budget))
+        return 0;
+    
+    return rts_scheduler_resize(s, t, budget);
+}
+
+// a budget of its own the task overran overrun_grow times since the last
+// check is grown by overrun_growth, up to the deadline, if the plugin and
+// the cpu can take it; returns 1 if it grew. The pieces of a split task
+// are fixed at its admission.
+static int rts_scheduler_overrun(struct rts_scheduler* s, struct rts_task* t) {
+    uint64_t overrun = rts_task_get_est_param(t, EST_OVERRUN);
+    uint64_t wcet = t->wcet;
+    uint64_t limit = rts_scheduler_budget_limit(t);
+    uint64_t grown;
+    
+    if(s->overrun_grow == 0 || wcet == 0 || t->nsplit != 0 || overrun - t->overrun_seen < s->overrun_grow)
+        return 0;
+    
+    t->overrun_seen = overrun;
+    grown = wcet + wcet * s->overrun_growth;
+    
+    if(limit != 0 && grown > limit)
+        grown = limit;
+    
+    return rts_scheduler_grow(s, t, grown);
+}
+
+// scale of the reference budget, 0 without activations since the last
+// step. The error is the ratio of the activations that missed minus the
+// target; the integral is bounded, so a long run without misses cannot
+// hold the budget down once they start
+static double rts_scheduler_control_pi(struct rts_scheduler* s, struct rts_task* t) {
+    uint32_t nact = t->est_nact - t->ctl_nact;
+    uint64_t miss = rts_task_get_est_param(t, EST_MISS) + rts_task_get_est_param(t, EST_OVERRUN);
+    double err, scale;
+    
+    if(nact == 0)
+        return 0;
+    
+    err = (miss - t->ctl_miss) / (double)nact - s->ctl_miss;
+    t->ctl_nact = t->est_nact;
+    t->ctl_miss = miss;
+    t->ctl_integral += err;
+    
+    if(t->ctl_integral > SCHED_CTL_WINDUP)
+        t->ctl_integral = SCHED_CTL_WINDUP;
+    else if(t->ctl_integral < -SCHED_CTL_WINDUP)
+        t->ctl_integral = -SCHED_CTL_WINDUP;
+    
+    scale = 1 + s->ctl_kp * err + s->ctl_ki * t->ctl_integral;
+    
+    if(scale < SCHED_CTL_SCALE_MIN)
+        return SCHED_CTL_SCALE_MIN;
+    
+    if(scale > SCHED_CTL_SCALE_MAX)
+        return SCHED_CTL_SCALE_MAX;
+    
+    return scale;
+}
+
+// budget the controller wants for t, t->wcet if it leaves it alone: only
+// budgets of their own are controlled, once the client sampled some
+// execution times. The reference is the estimated wcet; the quantile law
+// jumps up to it and closes ctl_gain of the slack above it at each step,
+// the PI law scales it to hold the miss ratio at ctl_miss.
+static uint64_t rts_scheduler_control(struct rts_scheduler* s, struct rts_task* t) {
+    uint64_t limit = rts_scheduler_budget_limit(t);
+    uint64_t ref, budget;
+    double scale;
+    
+    if(t->wcet == 0 || t->nsplit != 0 || rts_task_est_load(t, s->wcet_quantile, s->wcet_margin) < 0)
+        return t->wcet;
+    
+    if(t->est_quantile == 0)
+        return t->wcet;
+    
+    ref = t->est_quantile + t->est_quantile * s->wcet_margin;
+    
+    if(s->controller == CTL_PI) {
+        scale = rts_scheduler_control_pi(s, t);
+        
+        if(scale == 0)
+            return t->wcet;
+        
+        budget = ref * scale;
+    } else if(ref >= t->wcet)
+        budget = ref;
+    else
+        budget = t->wcet - (t->wcet - ref) * s->ctl_gain;
+    
+    if(limit != 0 && budget > limit)
+        budget = limit;
+    
+    if(budget < SCHED_CTL_MIN_BUDGET)
+        budget = SCHED_CTL_MIN_BUDGET;
+    
+    // small moves are not worth a kernel update
+    if(budget < t->wcet + t->wcet * SCHED_CTL_DEADBAND && budget + t->wcet * SCHED_CTL_DEADBAND > t->wcet)
+        return t->wcet;
+    
+    return budget;
+}
+
+// positions do not move during a refresh: the scratch arrays follow them
+int rts_scheduler_reevaluate(struct rts_scheduler* s) {
+    int npush = 0;
+    uint32_t n = rts_taskset_get_size(s->taskset);
+    uint32_t* prio;
+    uint64_t* budget;
+    char* changed;
+    struct rts_task* t;
+    
+    prio = arena_alloc(&(s->scratch), n * sizeof(uint32_t));
+    budget = arena_alloc(&(s->scratch), n * sizeof(uint64_t));
+    changed = arena_alloc(&(s->scratch), n);
+    
+    if(prio == NULL || budget == NULL || changed == NULL)
+        return -1;
+    
+    for(uint32_t i = 0; i < n; i++) {
+        t = s->taskset->tasks[i];
+        prio[i] = t->schedprio;
+        changed[i] = rts_scheduler_est_changed(t);
+        
+        // its thread is sent back to the default policy, as on a detach
+        if(t->tid != 0 && rts_scheduler_split_failed(t)) {
+            rts_scheduler_deschedule(s, t);
+            t->tid = 0;
+        }
+        
+        if(changed[i])
+            rts_scheduler_refresh_util(s, t);
+        
+        if(s->controller == CTL_OFF)
+            changed[i] |= rts_scheduler_overrun(s, t);
+        else
+            budget[i] = rts_scheduler_control(s, t);
+    }
+    
+    // budgets shrink first: the slack they give back is there for the
+    // ones growing, each of which takes what its plugin admits on its cpu
+    for(uint32_t i = 0; i < n && s->controller != CTL_OFF; i++)
+        if(budget[i] < s->taskset->tasks[i]->wcet)
+            changed[i] |= rts_scheduler_resize(s, s->taskset->tasks[i], budget[i]);
+    
+    for(uint32_t i = 0; i < n && s->controller != CTL_OFF; i++) {
+        t = s->taskset->tasks[i];
+        
+        for(int k = 0; k < SCHED_CTL_TRIES && budget[i] > t->wcet; k++) {
+            if(rts_scheduler_grow(s, t, budget[i])) {
+                changed[i] = 1;
+                break;
+            }
+            
+            budget[i] = t->wcet + (budget[i] - t->wcet) / 2;
+        }
+    }
+    
+    rts_scheduler_refresh_prios(s);
+    
+    for(uint32_t i = 0; i < n; i++) {
+        t = s->taskset->tasks[i];
+        
+        if(t->tid == 0 || (!changed[i] && prio[i] == t->schedprio))
+            continue;
+        
+        if(rts_scheduler_schedule(s, t) == 0)
+            npush++;
+    }
+    
+    return npush;
+}
+
 float rts_scheduler_get_free_util(struct rts_scheduler* s) {
     float sys_util = 0;
     
@@ -169,78 +864,130 @@ float rts_scheduler_get_remaining_util(struct rts_scheduler* s) {
     return free_util / s->num_of_cpu;
 }
 
+float rts_scheduler_get_packing_efficiency(struct rts_scheduler* s) {
+    float used = 0;
+    float capacity = 0;
+    
+    for(int i = 0; i < s->num_of_cpu; i++) {
+        if(s->sys_rt_curr_free_utils[i] >= s->sys_rt_free_utils[i])
+            continue;
+        
+        used += s->sys_rt_free_utils[i] - s->sys_rt_curr_free_utils[i];
+        capacity += s->sys_rt_free_utils[i];
+    }
+    
+    return capacity > 0 ? used / capacity : 0;
+}
+
+float rts_scheduler_get_acceptance_ratio(struct rts_scheduler* s) {
+    uint32_t total = s->admitted + s->rejected;
+    
+    return total > 0 ? s->admitted / (float)total : 1;
+}
+
+const char* rts_scheduler_placement_str(enum PLACEMENT p) {
+    return p < NUM_OF_PLACEMENT ? placement_str[p] : "UNKNOWN";
+}
+
+const char* rts_scheduler_controller_str(enum CONTROLLER c) {
+    return c < NUM_OF_CONTROLLER ? controller_str[c] : "UNKNOWN";
+}
+
 rsv_t rts_scheduler_rsv_create(struct rts_scheduler* s, struct rts_params* tp, pid_t ppid) {
     struct rts_task* t;
     
-    rts_task_init(&t, 0, tp->clk);
+    t = rts_scheduler_task_create(s, tp, ppid);
     
-    t->id = ++s->next_rsv_id;
-    t->ptid = ppid;
-    t->period = tp->period;
-    t->wcet = tp->budget;
-    t->deadline = tp->deadline;
-    t->priority = tp->priority;
-    t->est_param = tp->estimatedp;
+    if(t == NULL)
+        return -1;
+    
+    if(rts_scheduler_admit(s, t, tp) < 0) {
+        rts_scheduler_task_release(s, t);
+        return -1;
+    }
         
-    if(rts_scheduler_mem_attach(&(t->est_param)) < 0)
+    return t->id;
+}
+
+int rts_scheduler_rsv_create_attach(struct rts_scheduler* s, struct rts_params* tp, pid_t ppid, pid_t pid, rsv_t* rsvid) {
+    struct rts_task* t;
+    
+    // a group runs no thread of its own
+    if(tp->flags & RTS_RSV_GROUP)
         return -1;
     
-    rts_task_update_util(t);
-    t->util = rts_task_get_util(t);
+    t = rts_scheduler_task_create(s, tp, ppid);
     
-    if(rts_scheduler_assign(s, t) < 0)
+    if(t == NULL)
         return -1;
-        
-    return s->next_rsv_id;
+    
+    if(rts_scheduler_admit(s, t, tp) < 0) {
+        rts_scheduler_task_release(s, t);
+        return -1;
+    }
+    
+    t->tid = pid;
+    
+    if(rts_scheduler_schedule(s, t) < 0) {
+        // affinity may already be changed: put the thread back before forgetting it
+        rts_scheduler_deschedule(s, t);
+        rts_scheduler_dismiss(s, t);
+        rts_scheduler_task_release(s, t);
+        return -2;
+    }
+    
+    *rsvid = t->id;
+    return 0;
 }
 
 int rts_scheduler_rsv_attach(struct rts_scheduler* s, rsv_t rsvid, pid_t pid) {
     struct rts_task* t;
-    iterator_t iterator;
     
-    iterator = rts_taskset_iterator_init(s->taskset);
+    t = rts_scheduler_search(s, rsvid);
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        
-        if(t->id == rsvid) {
-            t->tid = pid;
-            return rts_scheduler_schedule(s, t);
-        }
-    } 
+    if(t == NULL || t->members != NULL || rts_scheduler_split_failed(t))
+        return -1;
     
-    return -1;
+    t->tid = pid;
+    return rts_scheduler_schedule(s, t);
 }
 
 int rts_scheduler_rsv_detach(struct rts_scheduler* s, rsv_t rsvid) {
+    int ret;
     struct rts_task* t;
-    iterator_t iterator;
     
-    iterator = rts_taskset_iterator_init(s->taskset);
+    t = rts_scheduler_search(s, rsvid);
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        
-        if(t->id == rsvid)
-            return rts_scheduler_deschedule(s, t);
-    } 
+    if(t == NULL || t->members != NULL)
+        return -1;
     
-    return -1;
+    ret = rts_scheduler_deschedule(s, t);
+    t->tid = 0;
+    
+    return ret;
 }
 
 int rts_scheduler_rsv_destroy(struct rts_scheduler* s, rsv_t rsvid) {
     struct rts_task* t;
     
-    t = rts_taskset_remove_by_rsvid(s->taskset, rsvid);
+    t = rts_scheduler_search(s, rsvid);
     
-    if(t == NULL)
+    if(t == NULL || (t->members != NULL && rts_taskset_get_size(t->members) > 0))
         return -1;
     
-    rts_scheduler_remove_utils(s, t);
-    s->plugin[t->pluginid].t_remove_from_utils(&(s->plugin[t->pluginid]), t);
-    
-    rts_scheduler_mem_detach(&(t->est_param));
-    rts_task_destroy(t);
+    rts_scheduler_dismiss(s, t);
+    rts_scheduler_task_release(s, t);
         
     return 0;
+}
+
+struct rts_task* rts_scheduler_search(struct rts_scheduler* s, rsv_t rsvid) {
+    struct rts_task* t;
+    
+    t = rts_taskset_search(s->taskset, rsvid);
+    
+    if(t == NULL)
+        t = rts_taskset_search(&(s->members), rsvid);
+    
+    return t;
 }
\ No newline at end of file
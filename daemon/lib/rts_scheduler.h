@@ -2,8 +2,50 @@
 #define RTS_SCHEDULER_H
 
 #include "rts_types.h"
+#include "rts_config.h"
+#include "rts_taskset.h"
+#include "../components/workpool.h"
+#include "../components/slab.h"
+#include "../components/arena.h"
 #include <sys/types.h>
 
+#define SCHED_POOL_MAX 64       // upper bound on admission worker threads
+#define SCHED_PARALLEL_MIN 8    // fewer (plugin, cpu) tests run in line
+#define SCHED_TASK_CHUNK 64     // tasks taken from the heap at once
+#define SCHED_SCRATCH_SIZE 16384 // initial scratch memory of a request [B]
+#define SCHED_UTIL_ONE (1LL << 32) // utilization 1 in the fixed point sums
+#define SCHED_WCET_PERCENTILE 99.0 // execution times covered by an estimated wcet [%]
+#define SCHED_WCET_MARGIN 10.0  // added to an estimated wcet [%]
+#define SCHED_OVERRUN_GROW 3    // overruns of a budget before it is grown
+#define SCHED_OVERRUN_GROWTH 10.0 // growth of an overrun budget [%]
+#define SCHED_CTL_GAIN 25.0     // slack reclaimed at each control step [%]
+#define SCHED_CTL_MISS 1.0      // activations allowed to miss, PI controller [%]
+#define SCHED_CTL_KP 2.0        // proportional gain, PI controller
+#define SCHED_CTL_KI 0.5        // integral gain, PI controller
+#define SCHED_CTL_WINDUP 1.0    // bound of the integral, PI controller
+#define SCHED_CTL_SCALE_MIN 0.5 // smallest budget, times the reference
+#define SCHED_CTL_SCALE_MAX 2.0 // largest budget, times the reference
+#define SCHED_CTL_DEADBAND 0.02 // budget changes below it are not pushed
+#define SCHED_CTL_MIN_BUDGET 1024 // smallest budget [ns], as SCHED_DEADLINE
+#define SCHED_CTL_TRIES 4       // halvings of a growth the plugin does not admit
+
+// cpu chosen among those where the selected plugin admits the task
+enum PLACEMENT {
+    PLACE_FIRST_FIT,            // lowest cpu
+    PLACE_BEST_FIT,             // least free utilization
+    PLACE_WORST_FIT,            // most free utilization
+    PLACE_NEXT_FIT,             // first from the last used cpu on
+    NUM_OF_PLACEMENT
+};
+
+// law resizing the budgets of their own at each re-evaluation
+enum CONTROLLER {
+    CTL_OFF,                    // budgets only grow on overruns
+    CTL_QUANTILE,               // track the estimated wcet
+    CTL_PI,                     // hold the miss ratio at a target
+    NUM_OF_CONTROLLER
+};
+
 struct rts_taskset;
 struct rts_plugin;
 struct rts_task;
@@ -15,31 +57,87 @@ struct rts_scheduler {
     int sys_rt_runtime;
     int sys_rt_period;
     float* sys_rt_free_utils;
-    float* sys_rt_curr_free_utils;
+    float* sys_rt_curr_free_utils;  // follows cpu_load
+    int64_t* cpu_load;          // [cpu] admitted utilization, fixed point
+    int64_t* plugin_load;       // [plugin][cpu] admitted utilization, fixed point
+    int64_t* charge_tmp;        // [2][cpu] charges of the task being refreshed
+    char* cpu_overloaded;       // [cpu] 1 while its load is above 1
+    uint32_t overloaded;        // number of cpus overloaded
+    char* plugin_dirty;         // [plugin] tasks refreshed since the last prio refresh
     struct rts_taskset* taskset;
+    struct rts_taskset members; // tasks admitted inside groups, out of the plugin analyses
     struct rts_plugin* plugin;
+    struct workpool pool;
+    struct slab task_slab;      // storage of the admitted tasks
+    struct arena scratch;       // temporaries of the current request
+    float* test_scores;         // [plugin][cpu] results of the last admission
+    struct rts_config config;
+    enum PLACEMENT placement;
+    int split_tasks;            // split tasks no single cpu can hold
+    double wcet_quantile;       // of the execution times, for estimated wcets
+    double wcet_margin;         // fraction added to estimated wcets
+    uint32_t overrun_grow;      // overruns before a budget grows, 0 never
+    double overrun_growth;      // fraction added to an overrun budget
+    enum CONTROLLER controller;
+    double ctl_gain;            // fraction of the slack reclaimed at each step
+    double ctl_miss;            // miss ratio targeted by the PI controller
+    double ctl_kp;
+    double ctl_ki;
+    int next_fit_cpu;
+    uint32_t admitted;
+    uint32_t rejected;
 };
 
 void rts_scheduler_init(struct rts_scheduler* s, struct rts_taskset* ts, int rt_period, int rt_runtime);
 
 void rts_scheduler_destroy(struct rts_scheduler* s);
 
+// releases the temporaries of the request just served
+void rts_scheduler_end_request(struct rts_scheduler* s);
+
 void rts_scheduler_delete(struct rts_scheduler* s, pid_t pid);
 
+// re-reads the tasks whose estimates changed since the last refresh;
+// returns minus the number of cpus overloaded (-1 if only a plugin
+// test fails), 0 otherwise
 int rts_scheduler_refresh_utils(struct rts_scheduler* s);
 
+// priorities of the plugins with tasks refreshed since the last call
 void rts_scheduler_refresh_prios(struct rts_scheduler* s);
 
 int rts_scheduler_refresh_util(struct rts_scheduler* s, struct rts_task* t);
 
 void rts_scheduler_refresh_prio(struct rts_scheduler* s, struct rts_task* t);
 
+// background re-evaluation: detaches the split tasks whose client could
+// not move between the pieces, refreshes the tasks whose estimates changed,
+// runs a step of the budget controller and pushes the attached tasks whose
+// parameters moved to the kernel; returns
+// the number of threads updated, -1 without scratch memory
+int rts_scheduler_reevaluate(struct rts_scheduler* s);
+
 float rts_scheduler_get_free_util(struct rts_scheduler* s);
 
 float rts_scheduler_get_remaining_util(struct rts_scheduler* s);
 
+// admitted utilization over the capacity of the cpus hosting at least one task
+float rts_scheduler_get_packing_efficiency(struct rts_scheduler* s);
+
+float rts_scheduler_get_acceptance_ratio(struct rts_scheduler* s);
+
+const char* rts_scheduler_placement_str(enum PLACEMENT p);
+
+const char* rts_scheduler_controller_str(enum CONTROLLER c);
+
+// a reservation naming a group in tp->group is admitted inside it, by a
+// test over the members of the group only
 rsv_t rts_scheduler_rsv_create(struct rts_scheduler* s, struct rts_params* tp, pid_t ppid);
 
+// admits the reservation and moves pid into it in one step; returns -1 if the
+// reservation is not admitted, -2 if the kernel refused it (nothing is kept)
+int rts_scheduler_rsv_create_attach(struct rts_scheduler* s, struct rts_params* tp, pid_t ppid, pid_t pid, rsv_t* rsvid);
+
+// a split reservation whose client failed to move is not attached again
 int rts_scheduler_rsv_attach(struct rts_scheduler* s, rsv_t rsvid, pid_t pid);
 
 int rts_scheduler_rsv_detach(struct rts_scheduler* s, rsv_t rsvid);
@@ -48,7 +146,11 @@ float rts_scheduler_rsv_budget(struct rts_scheduler* s, rsv_t rsvid);
 
 float rts_scheduler_rsv_rem_budget(struct rts_scheduler* s, rsv_t rsvid);
 
+// a group is destroyed once its members are
 int rts_scheduler_rsv_destroy(struct rts_scheduler* s, rsv_t rsvid);
 
+// the reservation rsvid, admitted by the node or inside a group
+struct rts_task* rts_scheduler_search(struct rts_scheduler* s, rsv_t rsvid);
+
 #endif	// RTS_SCHEDULER_H
 
@@ -0,0 +1,168 @@
+#include "rts_snapshot.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// DAEMON (WRITER) ----
+
+int rts_snapshot_create(struct rts_snapshot* s) {
+    int fd;
+    void* addr;
+    
+    rts_snapshot_init(s);
+    
+    // readable by every client, writable by the daemon only
+    shm_unlink(SNAPSHOT_NAME);
+    fd = shm_open(SNAPSHOT_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    
+    if(fd < 0)
+        return -1;
+    
+    if(fchmod(fd, 0644) < 0 || ftruncate(fd, sizeof(struct rts_snapshot_data)) < 0) {
+        close(fd);
+        shm_unlink(SNAPSHOT_NAME);
+        return -1;
+    }
+    
+    addr = mmap(NULL, sizeof(struct rts_snapshot_data), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    
+    if(addr == MAP_FAILED) {
+        shm_unlink(SNAPSHOT_NAME);
+        return -1;
+    }
+    
+    s->owner = 1;
+    s->data = addr;
+    return 0;
+}
+
+void rts_snapshot_destroy(struct rts_snapshot* s) {
+    if(s->data == NULL)
+        return;
+    
+    rts_snapshot_write_begin(s)->valid = 0;
+    rts_snapshot_write_end(s);
+    rts_snapshot_close(s);
+    shm_unlink(SNAPSHOT_NAME);
+}
+
+struct rts_snapshot_data* rts_snapshot_write_begin(struct rts_snapshot* s) {
+    __atomic_store_n(&(s->data->seq), s->data->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return s->data;
+}
+
+void rts_snapshot_write_end(struct rts_snapshot* s) {
+    __atomic_store_n(&(s->data->seq), s->data->seq + 1, __ATOMIC_RELEASE);
+}
+
+// CLIENT (READER) ----
+
+void rts_snapshot_init(struct rts_snapshot* s) {
+    s->owner = 0;
+    s->data = NULL;
+}
+
+int rts_snapshot_open(struct rts_snapshot* s) {
+    int fd;
+    void* addr;
+    
+    rts_snapshot_init(s);
+    fd = shm_open(SNAPSHOT_NAME, O_RDONLY, 0);
+    
+    if(fd < 0)
+        return -1;
+    
+    addr = mmap(NULL, sizeof(struct rts_snapshot_data), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    
+    if(addr == MAP_FAILED)
+        return -1;
+    
+    s->data = addr;
+    return 0;
+}
+
+void rts_snapshot_close(struct rts_snapshot* s) {
+    if(s->data == NULL)
+        return;
+    
+    munmap(s->data, sizeof(struct rts_snapshot_data));
+    s->data = NULL;
+}
+
+int rts_snapshot_read(struct rts_snapshot* s, struct rts_snapshot_data* out) {
+    uint32_t seq;
+    size_t ncpu, nplg;
+    struct rts_snapshot_data* d = s->data;
+    
+    if(d == NULL)
+        return -1;
+    
+    for(int i = 0; i < SNAPSHOT_MAX_RETRY; i++) {
+        seq = __atomic_load_n(&(d->seq), __ATOMIC_ACQUIRE);
+        
+        if(seq & 1)
+            continue;
+        
+        out->valid = d->valid;
+        out->num_of_cpu = d->num_of_cpu;
+        out->num_of_plugin = d->num_of_plugin;
+        out->num_of_rsv = d->num_of_rsv;
+        out->placement = d->placement;
+        out->admitted = d->admitted;
+        out->rejected = d->rejected;
+        out->overloaded = d->overloaded;
+        out->packing_efficiency = d->packing_efficiency;
+
+        ncpu = out->num_of_cpu < SNAPSHOT_MAX_CPU ? out->num_of_cpu : SNAPSHOT_MAX_CPU;
+        nplg = out->num_of_plugin < SNAPSHOT_MAX_PLUGIN ? out->num_of_plugin : SNAPSHOT_MAX_PLUGIN;
+        memcpy(out->free_utils, d->free_utils, ncpu * sizeof(float));
+        memcpy(out->curr_free_utils, d->curr_free_utils, ncpu * sizeof(float));
+        memcpy(out->plugin_used_utils, d->plugin_used_utils, nplg * sizeof(float));
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        
+        if(__atomic_load_n(&(d->seq), __ATOMIC_RELAXED) == seq) {
+            out->seq = seq;
+            return out->valid ? 0 : -1;
+        }
+    }
+    
+    return -1;
+}
+
+int rts_snapshot_cap_query(struct rts_snapshot* s, enum QUERY_TYPE type, float* value) {
+    float* utils;
+    float sum = 0;
+    struct rts_snapshot_data d;
+    
+    if(rts_snapshot_read(s, &d) < 0 || d.num_of_cpu == 0 || d.num_of_cpu > SNAPSHOT_MAX_CPU)
+        return -1;
+    
+    switch(type) {
+        case RTS_BUDGET:
+            utils = d.free_utils;
+            break;
+        case RTS_REMAINING_BUDGET:
+            utils = d.curr_free_utils;
+            break;
+        case RTS_PACKING_EFFICIENCY:
+            *value = d.packing_efficiency;
+            return 0;
+        case RTS_ACCEPTANCE_RATIO:
+            *value = d.admitted + d.rejected > 0 ? d.admitted / (float)(d.admitted + d.rejected) : 1;
+            return 0;
+        default:
+            return -1;
+    }
+    
+    for(uint32_t i = 0; i < d.num_of_cpu; i++)
+        sum += utils[i];
+    
+    *value = sum / d.num_of_cpu;
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef RTS_SNAPSHOT_H
+#define RTS_SNAPSHOT_H
+
+#include "rts_types.h"
+#include <stdint.h>
+
+#define SNAPSHOT_NAME "/rts_snapshot"
+#define SNAPSHOT_MAX_CPU 256
+#define SNAPSHOT_MAX_PLUGIN 32
+#define SNAPSHOT_MAX_RETRY 64
+
+// Capacity view published by the daemon. seq is odd while an update
+// is in progress; readers retry until they see the same even value
+// before and after the copy. valid drops to 0 when the daemon exits.
+struct rts_snapshot_data {
+    uint32_t seq;
+    uint32_t valid;
+    uint32_t num_of_cpu;
+    uint32_t num_of_plugin;
+    uint32_t num_of_rsv;
+    uint32_t placement;
+    uint32_t admitted;
+    uint32_t rejected;
+    uint32_t overloaded;            // cpus whose admitted utilization is above 1
+    float packing_efficiency;
+    float free_utils[SNAPSHOT_MAX_CPU];
+    float curr_free_utils[SNAPSHOT_MAX_CPU];
+    float plugin_used_utils[SNAPSHOT_MAX_PLUGIN];
+};
+
+struct rts_snapshot {
+    int owner;
+    struct rts_snapshot_data* data;
+};
+
+// DAEMON (WRITER) ----
+
+int rts_snapshot_create(struct rts_snapshot* s);
+
+void rts_snapshot_destroy(struct rts_snapshot* s);
+
+struct rts_snapshot_data* rts_snapshot_write_begin(struct rts_snapshot* s);
+
+void rts_snapshot_write_end(struct rts_snapshot* s);
+
+// CLIENT (READER) ----
+
+void rts_snapshot_init(struct rts_snapshot* s);
+
+int rts_snapshot_open(struct rts_snapshot* s);
+
+void rts_snapshot_close(struct rts_snapshot* s);
+
+int rts_snapshot_read(struct rts_snapshot* s, struct rts_snapshot_data* out);
+
+int rts_snapshot_cap_query(struct rts_snapshot* s, enum QUERY_TYPE type, float* value);
+
+#endif	// RTS_SNAPSHOT_H
@@ -14,24 +14,29 @@
 
 // Instanciate and initialize a real time task structure
 int rts_task_init(struct rts_task **tp, rsv_t id, clockid_t clk) {
-    (*tp) = calloc(1, sizeof(struct rts_task));
+    (*tp) = malloc(sizeof(struct rts_task));
     
     if((*tp) == NULL)
         return -1;
     
-    (*tp)->id = id;
-    (*tp)->clk = clk;
-    
+    rts_task_setup(*tp, id, clk);
     return 0;
 }
 
+// Initialize a real time task structure in memory owned by the caller
+void rts_task_setup(struct rts_task *tp, rsv_t id, clockid_t clk) {
+    memset(tp, 0, sizeof(struct rts_task));
+    tp->id = id;
+    tp->clk = clk;
+}
+
 // Instanciate and initialize a real time task structure from another one
 int rts_task_copy(struct rts_task *tp, struct rts_task *tp_copy) {
     tp = calloc(1, sizeof(struct rts_task));
-
+    
     if (tp == NULL)
         return 0;
-
+    
     memcpy(tp, tp_copy, sizeof(struct rts_task));
     return 1;
 }
@@ -51,45 +56,45 @@ void rts_task_set_wcet(struct rts_task* tp, uint64_t wcet) {
 }
 
 // Get the task worst case execution time
-uint32_t rts_task_get_wcet(struct rts_task* tp) {
+uint64_t rts_task_get_wcet(struct rts_task* tp) {
     return tp->wcet;
 }
 
-uint32_t rts_task_get_est_wcet(struct rts_task* tp) {
-    return tp->wcet != 0 ? tp->wcet : rts_task_get_est_param(tp, EST_WCET); 
+uint64_t rts_task_get_est_wcet(struct rts_task* tp) {
+    return tp->wcet != 0 ? tp->wcet : tp->est_wcet; 
 }
 
 // Set the task period
-void rts_task_set_period(struct rts_task* tp, uint32_t period) {
+void rts_task_set_period(struct rts_task* tp, uint64_t period) {
     tp->period = period;
 }
 
 // Get the task period
-uint32_t rts_task_get_period(struct rts_task* tp) {
+uint64_t rts_task_get_period(struct rts_task* tp) {
     return tp->period;
 }
 
-uint32_t rts_task_get_est_period(struct rts_task* tp) {
-    return tp->period != 0 ? tp->period : rts_task_get_est_param(tp, EST_PERIOD);
+uint64_t rts_task_get_est_period(struct rts_task* tp) {
+    return tp->period != 0 ? tp->period : tp->est_period;
 }
 
 // Set the relative deadline
-void rts_task_set_deadline(struct rts_task* tp, uint32_t deadline) {
+void rts_task_set_deadline(struct rts_task* tp, uint64_t deadline) {
     tp->deadline = deadline;
 }
 
 // Get the relative deadline
-uint32_t rts_task_get_deadline(struct rts_task* tp) {
+uint64_t rts_task_get_deadline(struct rts_task* tp) {
     return tp->deadline;
 }
 
-uint32_t rts_task_get_est_deadline(struct rts_task* tp) {    
+uint64_t rts_task_get_est_deadline(struct rts_task* tp) {    
     if(tp->deadline != 0)
         return tp->deadline;
     else if(tp->period != 0)
         return tp->period;
     
-    return rts_task_get_est_param(tp, EST_PERIOD);  
+    return tp->est_period;
 }
 
 // ---
@@ -154,7 +159,7 @@ int task_cmp(struct rts_task* tp1, struct rts_task* tp2, enum PARAM p, int flag)
 	
     if(flag != ASC && flag != DSC)
         flag = ASC;
-
+    
     switch (p) {
         case PERIOD:
             return flag * task_cmp_period(tp1, tp2);
@@ -169,18 +174,65 @@ int task_cmp(struct rts_task* tp1, struct rts_task* tp2, enum PARAM p, int flag)
     }
 }
 
-int rts_task_get_est_param(struct rts_task* t, int FLAG) {
-    return shatomic_get_value(&(t->est_param), FLAG);
+uint64_t rts_task_get_est_param(struct rts_task* t, int FLAG) {
+    return atomic_read(&(t->est_param.value[FLAG]));
+}
+
+// the client may be preempted, or die, inside a write section: after
+// TASK_EST_RETRY torn reads the task keeps its previous copy. Once the
+// client sampled some activations, the wcet is the quantile of their
+// execution times, capped to the largest one, plus the margin.
+int rts_task_est_load(struct rts_task* t, double quantile, double margin) {
+    uint64_t seq;
+    uint32_t nact, gen;
+    uint64_t period, wcet, top, q;
+    uint64_t hist[LOGHIST_NBUCKET];
+    atomic_t* est = t->est_param.value;
+    
+    for(int i = 0; i < TASK_EST_RETRY; i++) {
+        seq = atomic_seq_read_begin(&(est[EST_SEQ]));
+        nact = atomic_read(&(est[EST_NUM_ACTIVATION]));
+        period = atomic_read(&(est[EST_PERIOD]));
+        wcet = atomic_read(&(est[EST_WCET]));
+        gen = atomic_read(&(est[EST_GEN]));
+        top = atomic_read(&(est[EST_HIST_TOP]));
+        
+        if(top > LOGHIST_NBUCKET)
+            top = LOGHIST_NBUCKET;
+        
+        for(uint64_t b = 0; b < top; b++)
+            hist[b] = atomic_read(&(est[EST_HIST(b)]));
+        
+        if(atomic_seq_read_retry(&(est[EST_SEQ]), seq))
+            continue;
+        
+        q = loghist_quantile(hist, top, quantile);
+        
+        if(q > wcet)
+            q = wcet;
+        
+        if(q != 0)
+            wcet = q * (1 + margin);
+        
+        t->est_nact = nact;
+        t->est_period = period;
+        t->est_wcet = wcet;
+        t->est_quantile = q;
+        t->est_gen = gen;
+        return 0;
+    }
+    
+    return -1;
 }
 
 void rts_task_update_util(struct rts_task* t) {
-    uint32_t wcet;
-    uint32_t period;
+    uint64_t wcet;
+    uint64_t period;
     
     wcet = rts_task_get_est_wcet(t);
     period = rts_task_get_est_period(t);
     
-    t->util = (wcet / (float)period);    
+    t->util = (wcet / (double)period);    
 }
 
 float rts_task_get_util(struct rts_task* t) {
@@ -24,6 +24,10 @@ enum PARAM {
 #define ASC 1
 #define DSC -1
 
+#define TASK_EST_RETRY 64       // reads of the estimates before giving up
+
+struct rts_taskset;
+
 struct rts_task {
     rsv_t id;
     pid_t               ptid;		// parent tid
@@ -32,15 +36,32 @@ struct rts_task {
     uint32_t            cpu;
     
     float               util;           // task CPU utilization [0.0 - 1.0]
-    uint32_t		wcet;		// worst case ex time [microseconds]
-    uint32_t 		period;		// period of task [millisecond]
-    uint32_t 		deadline;	// relative deadline [millisecond]
+    uint64_t		wcet;		// worst case ex time [nanoseconds]
+    uint64_t 		period;		// period of task [nanoseconds]
+    uint64_t 		deadline;	// relative deadline [nanoseconds]
     uint32_t 		priority;	// user priority of task
+    uint32_t            flags;          // RTS_RSV_* of the reservation
     uint32_t            schedprio;      // scheduling real prio [LOW_PRIO, HIGH_PRIO]
 
     
     int                 pluginid;       // if != NONE -> the scheduling alg
-    struct shatomic     est_param;      // nactivation, wcet, period
+    
+    uint32_t            nsplit;         // pieces of a split task, 0 if not split
+    uint32_t            split_cpu[RTS_SPLIT_MAX];
+    uint64_t            split_runtime[RTS_SPLIT_MAX];   // [ns]
+    uint64_t            split_deadline[RTS_SPLIT_MAX];  // [ns]
+    struct rts_est      est_param;      // nactivation, wcet, period
+    uint32_t            est_gen;        // generation of est_param last read
+    uint32_t            est_nact;       // estimates read with est_gen
+    uint64_t            est_period;     // [ns]
+    uint64_t            est_wcet;       // [ns]
+    uint64_t            est_quantile;   // of the execution times [ns], 0 before any sample
+    uint64_t            overrun_seen;   // overruns at the last budget check
+    uint32_t            ctl_nact;       // activations at the last control step
+    uint64_t            ctl_miss;       // misses and overruns at the last control step
+    double              ctl_integral;   // sum of the miss ratio errors, PI controller
+    struct rts_task*    group;          // group admitting the task, NULL for the node
+    struct rts_taskset* members;        // tasks admitted inside, NULL if not a group
 };
 
 //------------------------------------------
@@ -50,6 +71,10 @@ struct rts_task {
 // instantiate and initialize a real time task structure
 int rts_task_init(struct rts_task **tp, rsv_t id, clockid_t clk);
 
+// initialize a real time task structure in memory owned by the caller
+// (e.g. taken from a slab), nothing is allocated
+void rts_task_setup(struct rts_task *tp, rsv_t id, clockid_t clk);
+
 // instantiate and initialize a real time task structure from another one
 int rts_task_copy(struct rts_task *tp, struct rts_task *tp_copy);
 
@@ -64,19 +89,28 @@ void rts_task_destroy(struct rts_task *tp);
 void rts_task_set_wcet(struct rts_task* tp, uint64_t wcet);
 
 // Get the task worst case execution time
-uint32_t rts_task_get_wcet(struct rts_task* tp);
+uint64_t rts_task_get_wcet(struct rts_task* tp);
+
+// Get the task worst case execution time, the estimated one if not set
+uint64_t rts_task_get_est_wcet(struct rts_task* tp);
 
 // Set the task period
-void rts_task_set_period(struct rts_task* tp, uint32_t period);
+void rts_task_set_period(struct rts_task* tp, uint64_t period);
 
 // Get the task period
-uint32_t rts_task_get_period(struct rts_task* tp);
+uint64_t rts_task_get_period(struct rts_task* tp);
+
+// Get the task period, the estimated one if not set
+uint64_t rts_task_get_est_period(struct rts_task* tp);
 
 // Set the relative deadline
-void rts_task_set_deadline(struct rts_task* tp, uint32_t deadline);
+void rts_task_set_deadline(struct rts_task* tp, uint64_t deadline);
 
 // Get the relative deadline
-uint32_t rts_task_get_deadline(struct rts_task* tp);
+uint64_t rts_task_get_deadline(struct rts_task* tp);
+
+// Get the relative deadline, the period (or the estimated one) if not set
+uint64_t rts_task_get_est_deadline(struct rts_task* tp);
 
 // Set the priority
 void set_priority(struct rts_task* tp, uint32_t priority);
@@ -89,7 +123,12 @@ float rts_task_calc_budget(struct rts_task* t);
 
 float rts_task_calc_rem_budget(struct rts_task* t);
 
-int rts_task_get_est_param(struct rts_task* t, int FLAG);
+uint64_t rts_task_get_est_param(struct rts_task* t, int FLAG);
+
+// copy the estimates published by the client into the task as a whole,
+// -1 if no consistent copy could be read (the last one is kept). The wcet
+// is taken at quantile [0, 1] of the execution times, grown by margin.
+int rts_task_est_load(struct rts_task* t, double quantile, double margin);
 
 void rts_task_update_util(struct rts_task* t);
 
@@ -2,11 +2,17 @@
  * @file rts_taskset.c
  * @author Gabriele Serra
  * @date 11 Oct 2018
- * @brief Contains the implementation of a taskset (linked list of real time task) 
+ * @brief Contains the implementation of a taskset (dense array of real time task) 
  *
  */
 
 #include "rts_taskset.h"
+#include "../components/arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TASKSET_MIN_CAPACITY 16
+#define TASKSET_NONE UINT32_MAX
 
 // -----------------------------------------------------
 // PRIVATE METHOD
@@ -19,43 +25,424 @@
  * 
  * @endinternal
  */
-static int rts_taskset_cmp_deadline_asc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, DEADLINE, ASC);
+static int rts_taskset_cmp_deadline_asc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, DEADLINE, ASC);
+}
+static int rts_taskset_cmp_deadline_dsc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, DEADLINE, DSC);
+}
+static int rts_taskset_cmp_priority_asc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, PRIORITY, ASC);
+}
+static int rts_taskset_cmp_priority_dsc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, PRIORITY, DSC);
+}
+static int rts_taskset_cmp_period_asc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, PERIOD, ASC);
+}
+static int rts_taskset_cmp_period_dsc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, PERIOD, DSC);
+}
+static int rts_taskset_cmp_wcet_asc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, WCET, ASC);
+}
+static int rts_taskset_cmp_wcet_dsc(const void* task1, const void* task2) {
+    return task_cmp(*(struct rts_task**) task1, *(struct rts_task**) task2, WCET, DSC);
+}
+
+/**
+ * @internal
+ *
+ * Fibonacci hashing of a key (reservation id or parent pid)
+ * on index_size slots.
+ * 
+ * @endinternal
+ */
+static uint32_t rts_taskset_hash(struct rts_taskset* ts, uint32_t key) {
+    return (key * 2654435761u) & (ts->index_size - 1);
+}
+
+/**
+ * @internal
+ *
+ * Return the slot of the index holding key, or the free slot
+ * where it would be placed.
+ * 
+ * @endinternal
+ */
+static uint32_t rts_taskset_index_find(struct rts_taskset* ts, uint32_t* keys, uint32_t key) {
+    uint32_t h = rts_taskset_hash(ts, key);
+    
+    while(keys[h] != 0 && keys[h] != key)
+        h = (h + 1) & (ts->index_size - 1);
+    
+    return h;
+}
+
+/**
+ * @internal
+ *
+ * Remove the slot h from the index. The following slots of the same
+ * cluster are moved back, so that no lookup stops early on the hole
+ * (linear probing without tombstones).
+ * 
+ * @endinternal
+ */
+static void rts_taskset_index_remove(struct rts_taskset* ts, uint32_t* keys, uint32_t* vals, uint32_t h) {
+    uint32_t mask = ts->index_size - 1;
+    uint32_t next, home;
+    
+    keys[h] = 0;
+    next = (h + 1) & mask;
+    
+    while(keys[next] != 0) {
+        home = rts_taskset_hash(ts, keys[next]);
+        
+        // move it if its home is not in the cyclic interval (h, next]
+        if(((next - home) & mask) >= ((next - h) & mask)) {
+            keys[h] = keys[next];
+            vals[h] = vals[next];
+            keys[next] = 0;
+            h = next;
+        }
+        
+        next = (next + 1) & mask;
+    }
+}
+
+/**
+ * @internal
+ *
+ * Key of the task in position i in the parent pid chain. Tasks
+ * without a parent are not indexed.
+ * 
+ * @endinternal
+ */
+static uint32_t rts_taskset_ppid_key(struct rts_taskset* ts, uint32_t i) {
+    return ts->tasks[i]->ptid;
+}
+
+/**
+ * @internal
+ *
+ * Key of the task in position i in the partition chain, from
+ * the columns: plugin and cpu in the two halves. It is 0, out of
+ * the chain, for a task taken out of its partition.
+ * 
+ * @endinternal
+ */
+static uint32_t rts_taskset_part_key(int pluginid, uint32_t cpu) {
+    if(pluginid < 0)
+        return 0;
+    
+    return (((uint32_t)pluginid & 0x7fff) << 16 | (cpu & 0xffff)) + 1;
+}
+
+static uint32_t rts_taskset_part_key_at(struct rts_taskset* ts, uint32_t i) {
+    return rts_taskset_part_key(ts->pluginid[i], ts->cpu[i]);
+}
+
+/**
+ * @internal
+ *
+ * Copy the fields of the task in position i in the columns and
+ * point its reservation id slot at i.
+ * 
+ * @endinternal
+ */
+static void rts_taskset_store(struct rts_taskset* ts, uint32_t i) {
+    struct rts_task* t = ts->tasks[i];
+    uint32_t h;
+    
+    ts->wcet[i] = t->wcet;
+    ts->period[i] = t->period;
+    ts->deadline[i] = t->deadline;
+    ts->priority[i] = t->priority;
+    ts->util[i] = t->util;
+    ts->cpu[i] = t->cpu;
+    ts->pluginid[i] = t->pluginid;
+    
+    h = rts_taskset_index_find(ts, ts->rsvid_key, t->id);
+    ts->rsvid_key[h] = t->id;
+    ts->rsvid_pos[h] = i;
 }
-static int rts_taskset_cmp_deadline_dsc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, DEADLINE, DSC);
+
+/**
+ * @internal
+ *
+ * Put the task in position i at the head of the list of key
+ * in the chain.
+ * 
+ * @endinternal
+ */
+static void rts_taskset_link(struct rts_taskset* ts, struct rts_taskset_chain* c, uint32_t i, uint32_t key) {
+    uint32_t h;
+    
+    c->prev[i] = TASKSET_NONE;
+    c->next[i] = TASKSET_NONE;
+    
+    if(key == 0)
+        return;
+    
+    h = rts_taskset_index_find(ts, c->key, key);
+    
+    if(c->key[h] == key) {
+        c->next[i] = c->head[h];
+        c->prev[c->head[h]] = i;
+    }
+    
+    c->key[h] = key;
+    c->head[h] = i;
 }
-static int rts_taskset_cmp_priority_asc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, PRIORITY, ASC);
+
+/**
+ * @internal
+ *
+ * Take the task in position i out of the list of key in the
+ * chain, the key leaves the index with its last task.
+ * 
+ * @endinternal
+ */
+static void rts_taskset_unlink(struct rts_taskset* ts, struct rts_taskset_chain* c, uint32_t i, uint32_t key) {
+    uint32_t prev = c->prev[i];
+    uint32_t next = c->next[i];
+    uint32_t h;
+    
+    if(key == 0)
+        return;
+    
+    if(next != TASKSET_NONE)
+        c->prev[next] = prev;
+    
+    if(prev != TASKSET_NONE) {
+        c->next[prev] = next;
+        return;
+    }
+    
+    h = rts_taskset_index_find(ts, c->key, key);
+    
+    if(next != TASKSET_NONE)
+        c->head[h] = next;
+    else
+        rts_taskset_index_remove(ts, c->key, c->head, h);
 }
-static int rts_taskset_cmp_priority_dsc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, PRIORITY, DSC);
+
+/**
+ * @internal
+ *
+ * The links of the task in position from, of the list of key,
+ * now belong to position to.
+ * 
+ * @endinternal
+ */
+static void rts_taskset_relink(struct rts_taskset* ts, struct rts_taskset_chain* c, 
+                               uint32_t from, uint32_t to, uint32_t key) {
+    uint32_t prev = c->prev[from];
+    uint32_t next = c->next[from];
+    
+    c->prev[to] = prev;
+    c->next[to] = next;
+    
+    if(next != TASKSET_NONE)
+        c->prev[next] = to;
+    
+    if(prev != TASKSET_NONE)
+        c->next[prev] = to;
+    else if(key != 0)
+        c->head[rts_taskset_index_find(ts, c->key, key)] = to;
+}
+
+/**
+ * @internal
+ *
+ * Move the task in position from to the free position to,
+ * following it in the indexes.
+ * 
+ * @endinternal
+ */
+static void rts_taskset_move(struct rts_taskset* ts, uint32_t from, uint32_t to) {
+    uint32_t part = rts_taskset_part_key_at(ts, from);
+    
+    ts->tasks[to] = ts->tasks[from];
+    rts_taskset_store(ts, to);
+    
+    rts_taskset_relink(ts, &(ts->by_ppid), from, to, rts_taskset_ppid_key(ts, to));
+    rts_taskset_relink(ts, &(ts->by_part), from, to, part);
+}
+
+/**
+ * @internal
+ *
+ * Rebuild columns and indexes from the array of tasks.
+ * 
+ * @endinternal
+ */
+static void rts_taskset_reindex(struct rts_taskset* ts) {
+    memset(ts->rsvid_key, 0, ts->index_size * sizeof(uint32_t));
+    memset(ts->by_ppid.key, 0, ts->index_size * sizeof(uint32_t));
+    memset(ts->by_part.key, 0, ts->index_size * sizeof(uint32_t));
+    
+    // backwards, so that each list keeps the order of the array
+    for(uint32_t i = ts->size; i-- > 0;) {
+        rts_taskset_store(ts, i);
+        rts_taskset_link(ts, &(ts->by_ppid), i, rts_taskset_ppid_key(ts, i));
+        rts_taskset_link(ts, &(ts->by_part), i, rts_taskset_part_key_at(ts, i));
+    }
+}
+
+static void* rts_taskset_alloc(struct rts_taskset* ts, size_t n) {
+    return ts->arena != NULL ? arena_alloc(ts->arena, n) : malloc(n);
 }
-static int rts_taskset_cmp_period_asc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, PERIOD, ASC);
+
+// memory of an arena is given back when the arena is reset
+static void rts_taskset_free(struct rts_taskset* ts, void* p) {
+    if(ts->arena == NULL)
+        free(p);
 }
-static int rts_taskset_cmp_period_dsc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, PERIOD, DSC);
+
+static int rts_taskset_chain_alloc(struct rts_taskset* ts, struct rts_taskset_chain* c, uint32_t capacity, uint32_t index_size) {
+    c->next = rts_taskset_alloc(ts, capacity * sizeof(uint32_t));
+    c->prev = rts_taskset_alloc(ts, capacity * sizeof(uint32_t));
+    c->key = rts_taskset_alloc(ts, index_size * sizeof(uint32_t));
+    c->head = rts_taskset_alloc(ts, index_size * sizeof(uint32_t));
+    
+    return c->next == NULL || c->prev == NULL || c->key == NULL || c->head == NULL ? -1 : 0;
 }
-static int rts_taskset_cmp_wcet_asc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, WCET, ASC);
+
+static void rts_taskset_chain_free(struct rts_taskset* ts, struct rts_taskset_chain* c) {
+    rts_taskset_free(ts, c->next);
+    rts_taskset_free(ts, c->prev);
+    rts_taskset_free(ts, c->key);
+    rts_taskset_free(ts, c->head);
 }
-static int rts_taskset_cmp_wcet_dsc(void* task1, void* task2) {
-    return task_cmp((struct rts_task*) task1, (struct rts_task*) task2, WCET, DSC);
+
+/**
+ * @internal
+ *
+ * Grow the columns to hold at least one more task and keep the
+ * indexes at most half full. Return -1 if the memory is over,
+ * leaving the taskset as it was.
+ * 
+ * @endinternal
+ */
+static int rts_taskset_reserve(struct rts_taskset* ts) {
+    struct rts_taskset grown;
+    uint32_t capacity;
+    int ppid_ok, part_ok;
+    
+    if(ts->size + 1 <= ts->capacity)
+        return 0;
+    
+    capacity = ts->capacity > 0 ? ts->capacity * 2 : TASKSET_MIN_CAPACITY;
+    
+    grown = *ts;
+    grown.capacity = capacity;
+    grown.index_size = capacity * 2;
+    grown.tasks = rts_taskset_alloc(&grown, (capacity + 1) * sizeof(struct rts_task*));
+    grown.wcet = rts_taskset_alloc(&grown, capacity * sizeof(uint64_t));
+    grown.period = rts_taskset_alloc(&grown, capacity * sizeof(uint64_t));
+    grown.deadline = rts_taskset_alloc(&grown, capacity * sizeof(uint64_t));
+    grown.priority = rts_taskset_alloc(&grown, capacity * sizeof(uint32_t));
+    grown.util = rts_taskset_alloc(&grown, capacity * sizeof(float));
+    grown.cpu = rts_taskset_alloc(&grown, capacity * sizeof(uint32_t));
+    grown.pluginid = rts_taskset_alloc(&grown, capacity * sizeof(int));
+    grown.rsvid_key = rts_taskset_alloc(&grown, grown.index_size * sizeof(uint32_t));
+    grown.rsvid_pos = rts_taskset_alloc(&grown, grown.index_size * sizeof(uint32_t));
+    ppid_ok = rts_taskset_chain_alloc(&grown, &(grown.by_ppid), capacity, grown.index_size);
+    part_ok = rts_taskset_chain_alloc(&grown, &(grown.by_part), capacity, grown.index_size);
+    
+    if(grown.tasks == NULL || grown.wcet == NULL || grown.period == NULL || grown.deadline == NULL ||
+       grown.priority == NULL || grown.util == NULL || grown.cpu == NULL || grown.pluginid == NULL ||
+       grown.rsvid_key == NULL || grown.rsvid_pos == NULL || ppid_ok < 0 || part_ok < 0) {
+        grown.size = 0;
+        rts_taskset_destroy(&grown);
+        return -1;
+    }
+    
+    if(ts->size > 0)
+        memcpy(grown.tasks, ts->tasks, ts->size * sizeof(struct rts_task*));
+    
+    grown.tasks[ts->size] = NULL;
+    rts_taskset_reindex(&grown);
+    
+    rts_taskset_destroy(ts);
+    *ts = grown;
+    
+    return 0;
 }
-static int rts_taskset_cmp_ppid(void* task, void* ppid) {
-    struct rts_task* t = (struct rts_task*)task;
-    pid_t p = (*(pid_t*)ppid); 
+
+/**
+ * @internal
+ *
+ * Put the task in position i, moving the following ones forward.
+ * 
+ * @endinternal
+ */
+static int rts_taskset_insert(struct rts_taskset* ts, struct rts_task* task, uint32_t i) {
+    if(rts_taskset_reserve(ts) < 0)
+        return -1;
     
-    return (t->ptid == p);
+    for(uint32_t k = ts->size; k > i; k--)
+        rts_taskset_move(ts, k - 1, k);
+    
+    ts->tasks[i] = task;
+    ts->size++;
+    ts->tasks[ts->size] = NULL;
+    
+    rts_taskset_store(ts, i);
+    rts_taskset_link(ts, &(ts->by_ppid), i, rts_taskset_ppid_key(ts, i));
+    rts_taskset_link(ts, &(ts->by_part), i, rts_taskset_part_key_at(ts, i));
+    
+    return 0;
 }
-static int rts_taskset_cmp_rsvid(void* task, void* rsvid) {
-    struct rts_task* t = (struct rts_task*)task;
-    rsv_t p = (*(rsv_t*)rsvid); 
+
+/**
+ * @internal
+ *
+ * Remove the task in position i, the last task takes its place.
+ * 
+ * @endinternal
+ */
+static struct rts_task* rts_taskset_remove_at(struct rts_taskset* ts, uint32_t i) {
+    struct rts_task* t = ts->tasks[i];
+    
+    rts_taskset_unlink(ts, &(ts->by_ppid), i, rts_taskset_ppid_key(ts, i));
+    rts_taskset_unlink(ts, &(ts->by_part), i, rts_taskset_part_key_at(ts, i));
+    rts_taskset_index_remove(ts, ts->rsvid_key, ts->rsvid_pos, rts_taskset_index_find(ts, ts->rsvid_key, t->id));
+    ts->size--;
     
-    return (t->id == p);
+    if(i != ts->size)
+        rts_taskset_move(ts, ts->size, i);
+    
+    ts->tasks[ts->size] = NULL;
+    return t;
 }
 
+/**
+ * @internal
+ *
+ * Return the first position whose task comes after task
+ * according to cmp, so that equal tasks keep the insertion order.
+ * 
+ * @endinternal
+ */
+static uint32_t rts_taskset_upper_bound(struct rts_taskset* ts, struct rts_task* task, 
+                                        int (*cmp)(const void*, const void*)) {
+    uint32_t lo = 0;
+    uint32_t hi = ts->size;
+    uint32_t mid;
+    
+    while(lo < hi) {
+        mid = (lo + hi) / 2;
+        
+        if(cmp(&(ts->tasks[mid]), &task) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    
+    return lo;
+}
 
 // -----------------------------------------------------
 // PUBLIC METHOD
@@ -65,12 +452,44 @@ static int rts_taskset_cmp_rsvid(void* task, void* rsvid) {
  * @internal
  *
  * The function ensures that the taskset is in a consistent
- * state before to be used.
+ * state before to be used. No memory is taken until the
+ * first task is added.
  * 
  * @endinternal
  */
 void rts_taskset_init(struct rts_taskset* ts) {
-    list_ptr_init(&(ts->tasks));
+    memset(ts, 0, sizeof(struct rts_taskset));
+}
+
+void rts_taskset_init_arena(struct rts_taskset* ts, struct arena* a) {
+    rts_taskset_init(ts);
+    ts->arena = a;
+}
+
+/**
+ * @internal
+ *
+ * The function frees the array and the columns. The tasks are not
+ * destroyed. A taskset on an arena keeps it.
+ * 
+ * @endinternal
+ */
+void rts_taskset_destroy(struct rts_taskset* ts) {
+    struct arena* a = ts->arena;
+    
+    rts_taskset_free(ts, ts->tasks);
+    rts_taskset_free(ts, ts->wcet);
+    rts_taskset_free(ts, ts->period);
+    rts_taskset_free(ts, ts->deadline);
+    rts_taskset_free(ts, ts->priority);
+    rts_taskset_free(ts, ts->util);
+    rts_taskset_free(ts, ts->cpu);
+    rts_taskset_free(ts, ts->pluginid);
+    rts_taskset_free(ts, ts->rsvid_key);
+    rts_taskset_free(ts, ts->rsvid_pos);
+    rts_taskset_chain_free(ts, &(ts->by_ppid));
+    rts_taskset_chain_free(ts, &(ts->by_part));
+    rts_taskset_init_arena(ts, a);
 }
 
 /**
@@ -82,7 +501,7 @@ void rts_taskset_init(struct rts_taskset* ts) {
  * @endinternal
  */
 int rts_taskset_is_empty(struct rts_taskset* ts) {
-    return list_ptr_is_empty(&(ts->tasks));
+    return ts->size == 0;
 }
 
 /**
@@ -94,18 +513,18 @@ int rts_taskset_is_empty(struct rts_taskset* ts) {
  * @endinternal
  */
 int rts_taskset_get_size(struct rts_taskset* ts) {
-    return list_ptr_get_size(&(ts->tasks));
+    return ts->size;
 }
 
 /**
  * @internal
  *
- * Add the provided element to the top of the taskset
+ * Add the provided element after the last task of the taskset
  * 
  * @endinternal
  */
-void rts_taskset_add_top(struct rts_taskset* ts, struct rts_task* task) {
-    list_ptr_add_top(&(ts->tasks), (void*) task);
+int rts_taskset_add_top(struct rts_taskset* ts, struct rts_task* task) {
+    return rts_taskset_insert(ts, task, ts->size);
 }
 
 /**
@@ -119,47 +538,49 @@ void rts_taskset_add_top(struct rts_taskset* ts, struct rts_task* task) {
  * 
  * @endinternal
  */
-void rts_taskset_add_sorted_dl(struct rts_taskset* ts, struct rts_task* task) {
-    list_ptr_add_sorted(&(ts->tasks), (void*) task, rts_taskset_cmp_deadline_asc);
+int rts_taskset_add_sorted_dl(struct rts_taskset* ts, struct rts_task* task) {
+    return rts_taskset_insert(ts, task, rts_taskset_upper_bound(ts, task, rts_taskset_cmp_deadline_asc));
 }
 
 /**
  * @internal
  *
  * The function allocate memory and add the task in the taskset 
- * in a sorted-way. Task with absolute deadline lower will be placed 
- * before task with absolute deadline greater. If there is another task
- * already in the taskset with equal deadline, the new task will be  
- * put after.
+ * in a sorted-way. Task with period lower will be placed before 
+ * task with period greater. If there is another task already in 
+ * the taskset with equal period, the new task will be put after.
  * 
  * @endinternal
  */
-void rts_taskset_add_sorted_pr(struct rts_taskset* ts, struct rts_task* task) {
-    list_ptr_add_sorted(&(ts->tasks), (void*) task, rts_taskset_cmp_period_asc);
+int rts_taskset_add_sorted_pr(struct rts_taskset* ts, struct rts_task* task) {
+    return rts_taskset_insert(ts, task, rts_taskset_upper_bound(ts, task, rts_taskset_cmp_period_asc));
 }
 
 /**
  * @internal
  *
- * Remove the first task of the taskset and frees memory.
- * If the taskset is empty, this function does nothing.
+ * Remove the first task of the taskset. The last task takes
+ * its place. If the taskset is empty, this function does nothing.
  * 
  * @endinternal
  */
 struct rts_task* rts_taskset_remove_top(struct rts_taskset* ts) {
-    return (struct rts_task*) list_ptr_remove_top(&(ts->tasks));
+    if(ts->size == 0)
+        return NULL;
+    
+    return rts_taskset_remove_at(ts, 0);
 }
 
 /**
  * @internal
  *
- * Simply returns a pointer to the first task of the list.
+ * Simply returns a pointer to the first task of the taskset.
  * If the taskset is empty, the function will return NULL.
  * 
  * @endinternal
  */
 struct rts_task* rts_taskset_get_top_task(struct rts_taskset* ts) {
-    return list_ptr_get_top_elem(&(ts->tasks));
+    return ts->size > 0 ? ts->tasks[0] : NULL;
 }
 
 /**
@@ -171,90 +592,158 @@ struct rts_task* rts_taskset_get_top_task(struct rts_taskset* ts) {
  * @endinternal
  */
 struct rts_task* rts_taskset_get_i_task(struct rts_taskset* ts, unsigned int i) {
-    return list_ptr_get_i_elem(&(ts->tasks), i);
-}
-
-/**
- * @internal
- * 
- * Return the pointer to i-th node of the list. The list is 0-based. 
- * If "i" is greater or equal to the list size, the function returns NULL.
- * 
- * @endinternal
- */
-struct node_ptr* rts_taskset_get_i_node(struct rts_taskset* ts, unsigned int i) {
-    return list_ptr_get_i_node(&(ts->tasks), i);
-}
-
-/**
- * @internal
- * 
- * Return the pointer to the node adjacent in the taskset. The caller
- * must ensure that node passed to the function is inside the list.
- * 
- * @endinternal
- */
-struct node_ptr* rts_taskset_get_next_node(struct rts_taskset* ts, struct node_ptr* node) {
-    return list_ptr_get_next_node(&(ts->tasks), node);
+    return i < ts->size ? ts->tasks[i] : NULL;
 }
 
 /**
  * @internal
  *
- * The function ensures that the taskset is in a consistent
- * state before to be used.
+ * Look up the reservation id in the index.
  * 
  * @endinternal
  */
 struct rts_task* rts_taskset_search(struct rts_taskset* ts, rsv_t rsvid) {
-    return list_ptr_search_elem(&(ts->tasks), (void*)&rsvid, rts_taskset_cmp_rsvid);
+    uint32_t h;
+    
+    if(ts->size == 0 || rsvid == 0)
+        return NULL;
+    
+    h = rts_taskset_index_find(ts, ts->rsvid_key, rsvid);
+    
+    return ts->rsvid_key[h] == rsvid ? ts->tasks[ts->rsvid_pos[h]] : NULL;
 }
 
 /**
  * @internal
  * 
- * Utilizes an in-place merge sort technique to sort the entire taskset.
+ * Sorts the array of tasks, then rebuilds columns and indexes.
  * Use one of WCET, PERIOD, DEADLINE, PRIORITY as enum value PARAM. If
- * the passed parameter is not valid, by default the taskset is sorted by
- * priority. Use ASC as flag to set an ascedent sorting or DSC on the
- * contrary. Other value are not valid, and in this case an ASC sorting
- * will be performed.
+ * the passed parameter is not valid, the taskset is left as it is. 
+ * Use ASC as flag to set an ascedent sorting or DSC on the contrary. 
  * 
  * @endinternal
  */
 void rts_taskset_sort(struct rts_taskset* ts, enum PARAM p, int flag) {
+    int (*cmp)(const void*, const void*);
+    
     switch (p) {
         case PERIOD:
-            if(flag == ASC)
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_period_asc);
-            else
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_period_dsc);
+            cmp = flag == DSC ? rts_taskset_cmp_period_dsc : rts_taskset_cmp_period_asc;
+            break;
         case DEADLINE:
-            if(flag == ASC)
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_deadline_asc);
-            else
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_deadline_dsc);
+            cmp = flag == DSC ? rts_taskset_cmp_deadline_dsc : rts_taskset_cmp_deadline_asc;
+            break;
         case PRIORITY:
-            if(flag == ASC)
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_priority_asc);
-            else
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_priority_dsc);
+            cmp = flag == DSC ? rts_taskset_cmp_priority_dsc : rts_taskset_cmp_priority_asc;
+            break;
         case WCET:
-            if(flag == ASC)
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_wcet_asc);
-            else
-                return list_ptr_sort(&(ts->tasks), rts_taskset_cmp_wcet_dsc);
-        default:
+            cmp = flag == DSC ? rts_taskset_cmp_wcet_dsc : rts_taskset_cmp_wcet_asc;
             break;
+        default:
+            return;
     }
+    
+    if(ts->size == 0)
+        return;
+    
+    qsort(ts->tasks, ts->size, sizeof(struct rts_task*), cmp);
+    rts_taskset_reindex(ts);
+}
+
+/**
+ * @internal
+ *
+ * A task whose plugin or cpu changed moves to its new partition.
+ * 
+ * @endinternal
+ */
+void rts_taskset_update(struct rts_taskset* ts, struct rts_task* task) {
+    uint32_t h, i, part;
+    
+    if(ts->size == 0)
+        return;
+    
+    h = rts_taskset_index_find(ts, ts->rsvid_key, task->id);
+    
+    if(ts->rsvid_key[h] != task->id || ts->tasks[ts->rsvid_pos[h]] != task)
+        return;
+    
+    i = ts->rsvid_pos[h];
+    part = rts_taskset_part_key_at(ts, i);
+    rts_taskset_store(ts, i);
+    
+    if(part == rts_taskset_part_key_at(ts, i))
+        return;
+    
+    rts_taskset_unlink(ts, &(ts->by_part), i, part);
+    rts_taskset_link(ts, &(ts->by_part), i, rts_taskset_part_key_at(ts, i));
+}
+
+void rts_taskset_part_leave(struct rts_taskset* ts, struct rts_task* task) {
+    uint32_t h, i;
+    
+    if(ts->size == 0)
+        return;
+    
+    h = rts_taskset_index_find(ts, ts->rsvid_key, task->id);
+    
+    if(ts->rsvid_key[h] != task->id || ts->tasks[ts->rsvid_pos[h]] != task)
+        return;
+    
+    i = ts->rsvid_pos[h];
+    rts_taskset_unlink(ts, &(ts->by_part), i, rts_taskset_part_key_at(ts, i));
+    ts->pluginid[i] = -1;
+    rts_taskset_link(ts, &(ts->by_part), i, 0);
+}
+
+int rts_taskset_part_first(struct rts_taskset* ts, int pluginid, int cpu) {
+    uint32_t key = rts_taskset_part_key(pluginid, cpu);
+    uint32_t h;
+    
+    if(ts->size == 0)
+        return -1;
+    
+    h = rts_taskset_index_find(ts, ts->by_part.key, key);
+    
+    return ts->by_part.key[h] == key ? (int)ts->by_part.head[h] : -1;
+}
+
+int rts_taskset_part_next(struct rts_taskset* ts, int i) {
+    return ts->by_part.next[i] != TASKSET_NONE ? (int)ts->by_part.next[i] : -1;
+}
+
+void rts_taskset_sum_utils(struct rts_taskset* ts, int pluginid, float* percpu, int ncpu) {
+    for(int c = 0; c < ncpu; c++)
+        for(int i = rts_taskset_part_first(ts, pluginid, c); i != -1; i = rts_taskset_part_next(ts, i))
+            percpu[c] += ts->util[i];
 }
 
 struct rts_task* rts_taskset_remove_by_ppid(struct rts_taskset* ts, pid_t ppid) {
-    return (struct rts_task*) list_ptr_remove(&(ts->tasks), (void*)&ppid, rts_taskset_cmp_ppid);
+    uint32_t h;
+    
+    if(ts->size == 0 || ppid == 0)
+        return NULL;
+    
+    h = rts_taskset_index_find(ts, ts->by_ppid.key, ppid);
+    
+    if(ts->by_ppid.key[h] != (uint32_t)ppid)
+        return NULL;
+    
+    return rts_taskset_remove_at(ts, ts->by_ppid.head[h]);
 }
 
 struct rts_task* rts_taskset_remove_by_rsvid(struct rts_taskset* ts, rsv_t rsvid) {
-    return (struct rts_task*) list_ptr_remove(&(ts->tasks), (void*)&rsvid, rts_taskset_cmp_rsvid);
+    uint32_t h;
+    
+    if(ts->size == 0 || rsvid == 0)
+        return NULL;
+    
+    h = rts_taskset_index_find(ts, ts->rsvid_key, rsvid);
+    
+    if(ts->rsvid_key[h] != rsvid)
+        return NULL;
+    
+    return rts_taskset_remove_at(ts, ts->rsvid_pos[h]);
 }
 
 void rts_taskset_remove_all_by_ppid(struct rts_taskset* ts, pid_t ppid) {
@@ -268,15 +757,15 @@ void rts_taskset_remove_all_by_ppid(struct rts_taskset* ts, pid_t ppid) {
 }
 
 iterator_t rts_taskset_iterator_init(struct rts_taskset* ts) {
-    return iterator_init(&(ts->tasks));
+    return ts->size > 0 ? ts->tasks : NULL;
 }
 
 iterator_t rts_taskset_iterator_get_next(iterator_t iterator) {
-    return iterator->next;
+    return *(iterator + 1) != NULL ? iterator + 1 : NULL;
 }
 
 struct rts_task* rts_taskset_iterator_get_elem(iterator_t iterator) {
-    return (struct rts_task*) (iterator_get_elem(iterator));
+    return *iterator;
 }
 
 
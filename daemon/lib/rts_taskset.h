@@ -2,34 +2,88 @@
  * @file rts_taskset.h
  * @author Gabriele Serra
  * @date 11 Oct 2018
- * @brief Contains the interface of a taskset (linked list of real time task) 
+ * @brief Contains the interface of a taskset (dense array of real time task) 
  *
- * This file contains the interface of a simple implementation of a taskset
- * namely a list taskset real time task. This is useful to store in the taskset any custom
- * element, using the a cast to (void*). This implementation utilizes list_ptr.h, 
- * an implementation of linked list of void* element.
+ * This file contains the interface of a taskset kept as a dense array of
+ * pointers to real time tasks. Next to it, the parameters read by the
+ * scheduling loops (wcet, period, deadline, priority, utilization, cpu and
+ * plugin) are kept in columns with the same index, so that a scan over the
+ * whole taskset reads contiguous memory only. An index on the reservation
+ * id gives constant time lookup and removal, an index on the parent pid
+ * links the tasks of each client so that they are removed in time linear
+ * in their number, and an index on plugin and cpu links the tasks of each
+ * partition so that a plugin visits its own tasks only. The task pointers
+ * are the stable handles: the position of a task changes when another one
+ * is removed, since the last task is moved in the hole.
  */
 
 #ifndef RTS_TASKSET_H
 #define RTS_TASKSET_H
 
-#include "../components/list_ptr.h"
 #include "rts_task.h"
 
+struct arena;
+
 // ---------------------------------------------
 // DATA STRUCTURES
 // ---------------------------------------------
 
+/**
+ * @brief Represent an index of lists of tasks sharing a key
+ * 
+ * The tasks with the same key are linked through their positions. An
+ * open addressing hash table maps each key to the first of its tasks.
+ */
+struct rts_taskset_chain {
+    uint32_t*           next;       /** next task with the same key */
+    uint32_t*           prev;       /** previous task with the same key */
+    uint32_t*           key;        /** key of each slot, 0 if free */
+    uint32_t*           head;       /** position of the first task of each slot */
+};
+
 /**
  * @brief Represent the taskset object
  * 
- * The structure rts_taskset contains a list_ptr. Inside
- * the taskset will be placed rt_tasks.
+ * The structure rts_taskset contains the array of tasks, terminated by
+ * NULL, and one column for each parameter used by the scheduling loops.
+ * The i-th element of each column belongs to the i-th task. Columns are
+ * a copy of the task fields: who changes a task inside the taskset calls
+ * rts_taskset_update. The indexes are open addressing hash tables sharing
+ * the size: one from reservation id to position, and the chains of the 
+ * tasks of each parent pid and of each partition (plugin, cpu). A
+ * taskset on an arena takes its memory from it and never frees it.
  */
 struct rts_taskset {
-    struct list_ptr tasks; /** the rt_task list  */
+    uint32_t            size;       /** number of tasks */
+    uint32_t            capacity;   /** number of tasks the columns can hold */
+    struct rts_task**   tasks;      /** the tasks, NULL after the last one */
+    
+    uint64_t*           wcet;       /** column of wcet */
+    uint64_t*           period;     /** column of period */
+    uint64_t*           deadline;   /** column of relative deadline */
+    uint32_t*           priority;   /** column of user priority */
+    float*              util;       /** column of utilization */
+    uint32_t*           cpu;        /** column of assigned cpu */
+    int*                pluginid;   /** column of assigned plugin */
+    
+    uint32_t            index_size; /** slots of each index, a power of two */
+    uint32_t*           rsvid_key;  /** reservation id of each slot, 0 if free */
+    uint32_t*           rsvid_pos;  /** position of the task of each slot */
+    
+    struct rts_taskset_chain by_ppid;   /** tasks of each parent pid */
+    struct rts_taskset_chain by_part;   /** tasks of each (plugin, cpu) */
+    
+    struct arena*       arena;      /** allocator of the columns, NULL for the heap */
 };
 
+/**
+ * @brief Represent an iterator object
+ * 
+ * The iterator points to an element of the array of tasks and is NULL
+ * after the last one.
+ */
+typedef struct rts_task** iterator_t;
+
 // ---------------------------------------------
 // MAIN METHODS
 // ---------------------------------------------
@@ -44,6 +98,27 @@ struct rts_taskset {
  */
 void rts_taskset_init(struct rts_taskset* ts);
 
+/**
+ * @brief Initialize a taskset whose memory comes from an arena
+ * 
+ * Meant for temporary tasksets: the memory is released in bulk when
+ * the arena is reset, the taskset must not be used after that.
+ * 
+ * @param ts pointer to the taskset to be initialized
+ * @param a arena providing the memory, NULL for the heap
+ */
+void rts_taskset_init_arena(struct rts_taskset* ts, struct arena* a);
+
+/**
+ * @brief Release the memory of the taskset
+ * 
+ * The function frees the array and the columns. The tasks are not
+ * destroyed. The taskset is left empty and can be used again.
+ * 
+ * @param ts pointer to the taskset to be destroyed
+ */
+void rts_taskset_destroy(struct rts_taskset* ts);
+
 /**
  * @brief Check if the taskset is empty
  * 
@@ -67,14 +142,16 @@ int rts_taskset_is_empty(struct rts_taskset* ts);
 int rts_taskset_get_size(struct rts_taskset* ts);
 
 /**
- * @brief Add the provided element to the top of the taskset
+ * @brief Add the provided element to the taskset
  * 
- * Add the provided element to the top of the taskset
+ * Add the provided element after the last task of the taskset, in
+ * constant amortized time.
  * 
  * @param ts pointer to taskset to be used
  * @param task pointer to the task to be added to the taskset
+ * @return 0 on success, -1 if the memory is over
  */
-void rts_taskset_add_top(struct rts_taskset* ts, struct rts_task* task);
+int rts_taskset_add_top(struct rts_taskset* ts, struct rts_task* task);
 
 /**
  * @brief Add the element to the taskset sorting by ASC deadline
@@ -87,88 +164,162 @@ void rts_taskset_add_top(struct rts_taskset* ts, struct rts_task* task);
  * 
  * @param ts pointer to taskset to be used
  * @param task pointer to the task to be added to the taskset
+ * @return 0 on success, -1 if the memory is over
  */
-void rts_taskset_add_sorted_dl(struct rts_taskset* ts, struct rts_task* task);
+int rts_taskset_add_sorted_dl(struct rts_taskset* ts, struct rts_task* task);
 
-void rts_taskset_add_sorted_pr(struct rts_taskset* ts, struct rts_task* task);
+int rts_taskset_add_sorted_pr(struct rts_taskset* ts, struct rts_task* task);
 
 /**
  * @brief Remove the top element of the taskset
  * 
- * Remove the first task of the taskset and frees memory.
+ * Remove the first task of the taskset. The last task takes its place.
  * If the taskset is empty, this function does nothing.
  * 
  * @param ts: pointer to taskset to be used
+ * @return the removed task, NULL if the taskset is empty
  */
 struct rts_task* rts_taskset_remove_top(struct rts_taskset* ts);
 
 /**
- * @brief Return a pointer to the first task of the list
+ * @brief Return a pointer to the first task of the taskset
  * 
- * Simply returns a pointer to the first task of the list.
+ * Simply returns a pointer to the first task of the taskset.
  * If the taskset is empty, the function will return NULL.
  * 
  * @param ts pointer to taskset to be used
- * @return pointer to the first task of the list
+ * @return pointer to the first task of the taskset
  */
 struct rts_task* rts_taskset_get_top_task(struct rts_taskset* ts);
 
 /**
  * @brief Return the pointer to the i-th task in the taskset
  * 
- * Return the pointer to the i-th task in the taskset. The taskset is 0-based. 
- * If "i" is greater or equal to the taskset size, the function returns NULL.
+ * Return the pointer to the i-th task in the taskset, in constant time. The
+ * taskset is 0-based. If "i" is greater or equal to the taskset size, the 
+ * function returns NULL.
  * 
  * @param ts pointer to taskset to be used
  * @param i the index of the task to be retrivied
- * @return pointer to the element contained in the i-th node of the taskset
+ * @return pointer to the i-th task of the taskset
  */
 struct rts_task* rts_taskset_get_i_task(struct rts_taskset* ts, unsigned int i);
 
 /**
- * @brief Return the pointer to the i-th node of taskset list
+ * @brief Sort (in place) the taskset
  * 
- * Return the pointer to i-th node of the list. The list is 0-based. 
- * If "i" is greater or equal to the list size, the function returns NULL.
+ * Sorts the entire taskset, columns and index included.
+ * Use one of WCET, PERIOD, DEADLINE, PRIORITY as enum value PARAM. If
+ * the passed parameter is not valid, the taskset is left as it is. Use
+ * ASC as flag to set an ascedent sorting or DSC on the contrary. Other
+ * value are not valid, and in this case an ASC sorting will be performed.
  * 
- * @param ts pointer to list to be used
- * @param i the index of the node to be retrivied
- * @return pointer to the i-th node of the list
+ * @param ts pointer to taskset to be sorted
+ * @param p parameter of task to be used to establish the order
+ * @param flag specify ASC for ascendent or DSC for descendent
  */
-struct node_ptr* rts_taskset_get_i_node(struct rts_taskset* ts, unsigned int i);
+void rts_taskset_sort(struct rts_taskset* ts, enum PARAM p, int flag);
 
 /**
- * @brief Return the pointer to the node adjacent in the taskset list
+ * @brief Copy the fields of the task in the columns
  * 
- * Return the pointer to the node adjacent in the taskset. The caller
- * must ensure that node passed to the function is inside the list.
+ * Called whenever wcet, period, deadline, priority, utilization, cpu or
+ * plugin of a task in the taskset change: a task migrated to another cpu
+ * or plugin moves to its new partition. If the task is not in the 
+ * taskset, this function does nothing.
  * 
- * @param ts pointer to list to be used
- * @param node the index of the node that will be used to get the adjacent
- * @return pointer to the adjacent node of the one passed
+ * @param ts pointer to taskset to be used
+ * @param task pointer to the changed task
  */
-struct node_ptr* rts_taskset_get_next_node(struct rts_taskset* ts, struct node_ptr* node);
+void rts_taskset_update(struct rts_taskset* ts, struct rts_task* task);
 
 /**
- * @brief Sort (in place) the taskset
+ * @brief Take a task out of its partition
  * 
- * Utilizes an in-place merge sort technique to sort the entire taskset.
- * Use one of WCET, PERIOD, DEADLINE, PRIORITY as enum value PARAM. If
- * the passed parameter is not valid, by default the taskset is sorted by
- * priority. Use ASC as flag to set an ascedent sorting or DSC on the
- * contrary. Other value are not valid, and in this case an ASC sorting
- * will be performed.
+ * The task keeps its position, but the partition loops do not visit it
+ * until rts_taskset_update puts it back: its plugin can test it again as
+ * a task not yet admitted. No task must be added or removed meanwhile.
+ * If the task is not in the taskset, this function does nothing.
  * 
- * @param l pointer to list to be used
- * @param p parameter of task to be used to establish the order
- * @param flag specify ASC for ascendent or DSC for descendent
+ * @param ts pointer to taskset to be used
+ * @param task pointer to the task
  */
-void rts_taskset_sort(struct rts_taskset* ts, enum PARAM p, int flag);
+void rts_taskset_part_leave(struct rts_taskset* ts, struct rts_task* task);
 
+/**
+ * @brief Return the first task of a partition
+ * 
+ * Return the position of the first task assigned to the plugin and the
+ * cpu, to be used as index of the columns. Together with
+ * rts_taskset_part_next it visits the partition only:
+ * 
+ *     for(i = rts_taskset_part_first(ts, p, c); i != -1; i = rts_taskset_part_next(ts, i))
+ * 
+ * Positions are valid until the taskset changes.
+ * 
+ * @param ts pointer to taskset to be used
+ * @param pluginid the plugin of the partition
+ * @param cpu the cpu of the partition
+ * @return the position of the first task, -1 if the partition is empty
+ */
+int rts_taskset_part_first(struct rts_taskset* ts, int pluginid, int cpu);
+
+/**
+ * @brief Return the next task of the same partition
+ * 
+ * @param ts pointer to taskset to be used
+ * @param i the position of a task
+ * @return the position of the next task, -1 after the last one
+ */
+int rts_taskset_part_next(struct rts_taskset* ts, int i);
+
+/**
+ * @brief Sum the utilization of the tasks of a plugin on each cpu
+ * 
+ * Adds to percpu[c] the utilization of the tasks of the plugin assigned
+ * to cpu c, visiting the partitions of the plugin only.
+ * 
+ * @param ts pointer to taskset to be used
+ * @param pluginid the plugin whose tasks are summed
+ * @param percpu the sums, one for each cpu
+ * @param ncpu the number of cpus
+ */
+void rts_taskset_sum_utils(struct rts_taskset* ts, int pluginid, float* percpu, int ncpu);
+
+/**
+ * @brief Return the task of a reservation
+ * 
+ * Look up the reservation id in the index, in constant time.
+ * 
+ * @param ts pointer to taskset to be used
+ * @param rsvid the reservation id
+ * @return pointer to the task, NULL if not in the taskset
+ */
 struct rts_task* rts_taskset_search(struct rts_taskset* ts, rsv_t rsvid);
 
+/**
+ * @brief Remove one of the tasks of a parent
+ * 
+ * Remove the task at the head of the list of the parent, in constant time.
+ * Calling it until NULL is returned removes the k tasks of a client
+ * in O(k).
+ * 
+ * @param ts pointer to taskset to be used
+ * @param ppid the parent pid
+ * @return the removed task, NULL if the parent has no task left
+ */
 struct rts_task* rts_taskset_remove_by_ppid(struct rts_taskset* ts, pid_t ppid);
 
+/**
+ * @brief Remove the task of a reservation
+ * 
+ * Remove the task of the reservation, in constant time. The last
+ * task takes its place.
+ * 
+ * @param ts pointer to taskset to be used
+ * @param rsvid the reservation id
+ * @return the removed task, NULL if not in the taskset
+ */
 struct rts_task* rts_taskset_remove_by_rsvid(struct rts_taskset* ts, rsv_t rsvid);
 
 iterator_t rts_taskset_iterator_init(struct rts_taskset* ts);
@@ -4,7 +4,8 @@
 #include <stdint.h>
 #include <time.h>
 #include <sys/types.h>
-#include "../components/shatomic.h"
+#include "../components/atomic.h"
+#include "../components/loghist.h"
 
 #define RTS_OK 0
 #define RTS_ERROR -1
@@ -15,18 +16,78 @@
 // estimated parameters
 
 #define EST_NUM_ACTIVATION  0   // default: 0 [pure number]
-#define EST_ABS_ACTIVATION  1   // default: time at first activation [ms] 
-#define EST_ABS_FINISHING   2   // default: time at first finishing time [ms]
-#define EST_PERIOD          3   // default: MAX_INT_32 [ms]
-#define EST_WCET            4   // default: MAX_INT_32 / 3 [ms]
-#define EST_PERTHREADCLK    5   // default: 0
-#define EST_NVALUE          6
+#define EST_ABS_ACTIVATION  1   // default: time at first activation [ns]
+#define EST_ABS_FINISHING   2   // default: time at first finishing time [ns]
+#define EST_PERIOD          3   // default: MAX_EST_PERIOD [ns]
+#define EST_WCET            4   // default: MAX_EST_WCET, then largest seen [ns]
+#define EST_PERTHREADCLK    5   // default: 0 [ns]
+
+// split reservations: the budget is run in pieces on different cpus, one
+// after the other. Each piece but the last has runtime = deadline (C=D) and
+// keeps RTS_SPLIT_GUARD_NS of its runtime unused: the thread moves on
+// when its budget is over, before the kernel can throttle it.
+
+#define RTS_SPLIT_MAX       4
+#define RTS_SPLIT_GUARD_NS  4000000 // one scheduler tick at 250 Hz
+
+#define EST_SPLIT_NUM           6   // default: 0, not split
+#define EST_SPLIT_PERIOD        7   // [ns]
+#define EST_SPLIT_CPU(k)        (8 + 3 * (k))
+#define EST_SPLIT_RUNTIME(k)    (9 + 3 * (k))   // [ns]
+#define EST_SPLIT_DEADLINE(k)   (10 + 3 * (k))  // relative to the piece start [ns]
+
+// bumped by the client whenever it moves the wcet or period estimate, so
+// that the daemon re-reads only the reservations that changed
+#define EST_GEN                 (8 + 3 * RTS_SPLIT_MAX)
+
+// sequence counter of the estimates: the client updates activations,
+// period, wcet, misses and generation inside one write section, the daemon
+// reads them as a consistent tuple (see atomic_seq_write_begin)
+#define EST_SEQ                 (9 + 3 * RTS_SPLIT_MAX)
+
+// budget overruns signalled by the kernel and deadlines missed, counted
+// by the client since the slot was taken
+#define EST_OVERRUN             (10 + 3 * RTS_SPLIT_MAX)
+#define EST_MISS                (11 + 3 * RTS_SPLIT_MAX)
+
+// set by the client of a split reservation when the kernel refused to move
+// its thread to a piece: it stops splitting and the daemon detaches it
+#define EST_SPLIT_FAIL          (12 + 3 * RTS_SPLIT_MAX)
+
+// execution time histogram of the last activations (see loghist.h): the
+// number of samples, the highest bucket in use plus one and the buckets.
+// The counters are halved every EST_HIST_WINDOW samples, so that old
+// outliers fade; the generation is bumped when a sample lands above the
+// buckets in use and every EST_HIST_STEP samples.
+#define EST_HIST_NUM            (13 + 3 * RTS_SPLIT_MAX)
+#define EST_HIST_TOP            (14 + 3 * RTS_SPLIT_MAX)
+#define EST_HIST(b)             (15 + 3 * RTS_SPLIT_MAX + (b))
+#define EST_HIST_WINDOW         1024
+#define EST_HIST_STEP           64
+#define EST_NVALUE              (15 + 3 * RTS_SPLIT_MAX + LOGHIST_NBUCKET)
+
+// the estimates of all the reservations of a client live in one table,
+// shared with the daemon once per connection
+#define EST_TABLE_SLOTS         1024
+
+// flags of a reservation: RTS_RSV_NOTIFY_OVERRUN has the kernel signal
+// (SIGXCPU) its threads when they run out of budget; they must be able to
+// take the signal
+#define RTS_RSV_NOTIFY_OVERRUN  0x1
+
+// RTS_RSV_GROUP makes the reservation a group: the periodic resource
+// (period, budget) is admitted on a cpu and runs no thread itself, the
+// reservations naming it in rts_params.group are admitted inside it by a
+// test over the group alone, and run on its cpu
+#define RTS_RSV_GROUP           0x2
 
 typedef uint32_t rsv_t;
 
 enum QUERY_TYPE {
     RTS_BUDGET,
-    RTS_REMAINING_BUDGET
+    RTS_REMAINING_BUDGET,
+    RTS_PACKING_EFFICIENCY,
+    RTS_ACCEPTANCE_RATIO
 };
 
 enum REFRESH_MODE {
@@ -40,11 +101,15 @@ enum REQ_TYPE {
     RTS_REFRESH_SINGLE,
     RTS_CAP_QUERY,
     RTS_RSV_CREATE,
+    RTS_RSV_CREATE_ATTACH,
     RTS_RSV_ATTACH,
     RTS_RSV_DETACH,
     RTS_RSV_QUERY,
     RTS_RSV_DESTROY,
-    RTS_DECONNECTION
+    RTS_DECONNECTION,
+    RTS_BATCH,
+    RTS_RING_SETUP,
+    RTS_EST_SETUP
 };
 
 enum REP_TYPE {
@@ -71,7 +136,11 @@ enum REP_TYPE {
     RTS_RSV_DESTROY_OK,
     RTS_RSV_DESTROY_ERR,
     RTS_DECONNECTION_OK,
-    RTS_DECONNECTION_ERR
+    RTS_DECONNECTION_ERR,
+    RTS_RING_SETUP_OK,
+    RTS_RING_SETUP_ERR,
+    RTS_EST_SETUP_OK,
+    RTS_EST_SETUP_ERR
 };
 
 enum CLIENT_STATE {
@@ -81,13 +150,22 @@ enum CLIENT_STATE {
     ERROR
 };
 
+// slot of a reservation in the estimator table of its client, the values
+// are reached through the mapping of the table in the reading process
+struct rts_est {
+    uint32_t    slot;
+    atomic_t*   value;
+};
+
 struct rts_params {
     clockid_t 		clk;
-    uint32_t		budget;		// worst case ex time [microseconds]
-    uint32_t 		period;		// period of task [millisecond]
-    uint32_t 		deadline;	// relative deadline [millisecond]
+    uint64_t		budget;		// worst case ex time [nanoseconds]
+    uint64_t 		period;		// period of task [nanoseconds]
+    uint64_t 		deadline;	// relative deadline [nanoseconds]
     uint32_t 		priority;	// priority of task [LOW_PRIO, HIGH_PRIO]
-    struct shatomic     estimatedp;     // nactivation, period, wcet
+    uint32_t            flags;          // RTS_RSV_*
+    rsv_t               group;          // group admitting the reservation, 0 for the node
+    struct rts_est      estimatedp;     // nactivation, period, wcet
 };
 
 struct rts_ids {
@@ -95,12 +173,19 @@ struct rts_ids {
     rsv_t rsvid;
 };
 
+struct rts_create_attach {
+    struct rts_params param;
+    pid_t pid;
+};
+
 struct rts_request {
     enum REQ_TYPE req_type;
     union {
         struct rts_ids ids;
         struct rts_params param;
+        struct rts_create_attach create_attach;
         enum QUERY_TYPE query_type;
+        uint32_t nreq;
     } payload;
 };
 
@@ -1,7 +1,43 @@
 #include "rts_utils.h"
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 
+#ifndef SYS_sched_setattr
+    #ifdef __x86_64__
+        #define SYS_sched_setattr 314
+    #elif defined(__i386__)
+        #define SYS_sched_setattr 351
+    #elif defined(__arm__)
+        #define SYS_sched_setattr 380
+    #endif
+#endif
+
+#define SCHED_DEADLINE_POLICY 6
+
+struct dl_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+void time_add_ns(struct timespec *t, uint64_t ns) {
+    t->tv_sec += NANO_TO_SEC(ns);
+    t->tv_nsec += ns % EXP9;
+    
+    if (t->tv_nsec >= EXP9) {
+        t->tv_nsec -= EXP9;
+        t->tv_sec += 1;
+    }
+}
+
 void time_add_us(struct timespec *t, uint64_t us) {
     t->tv_sec += MICRO_TO_SEC(us);               
     t->tv_nsec += MICRO_TO_NANO(us % EXP6);     
@@ -41,6 +77,15 @@ void time_copy(struct timespec* td, struct timespec* ts) {
     td->tv_nsec = ts->tv_nsec;
 }
 
+uint64_t timespec_to_ns(struct timespec *t) {
+    return SEC_TO_NANO((uint64_t)t->tv_sec) + t->tv_nsec;
+}
+
+void ns_to_timespec(struct timespec *t, uint64_t ns) {
+    t->tv_sec = NANO_TO_SEC(ns);
+    t->tv_nsec = ns % EXP9;
+}
+
 uint64_t timespec_to_us(struct timespec *t) {
     uint64_t us;
     
@@ -87,6 +132,13 @@ uint32_t get_time_now_ms(clockid_t clk) {
     return timespec_to_ms(&ts);
 }
 
+uint64_t get_time_now_ns(clockid_t clk) {
+    struct timespec ts;
+    
+    clock_gettime(clk, &ts);
+    return timespec_to_ns(&ts);
+}
+
 struct timespec get_thread_time() {
     struct timespec ts;
     
@@ -101,6 +153,13 @@ uint32_t get_thread_time_ms() {
     return timespec_to_ms(&ts);
 }
 
+uint64_t get_thread_time_ns() {
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return timespec_to_ns(&ts);
+}
+
 void compute_for(uint32_t exec_milli_max) {
     uint32_t exec_milli;
     struct timespec t_curr;
@@ -127,8 +186,23 @@ void wait_next_activation(struct timespec* t_act, uint32_t period_milli) {
 
 void set_timer(uint32_t milli) {
     struct itimerval t;
-    t.it_interval.tv_sec = 0;
-    t.it_interval.tv_usec = MILLI_TO_MICRO(milli);
+    t.it_interval.tv_sec = milli / 1000;
+    t.it_interval.tv_usec = MILLI_TO_MICRO(milli % 1000);
+    t.it_value = t.it_interval;     // 0 disarms the timer
 
     setitimer(ITIMER_REAL, &t, NULL);
-}
\ No newline at end of file
+}
+
+int set_sched_deadline(pid_t tid, uint64_t runtime, uint64_t deadline, uint64_t period, uint64_t flags) {
+    struct dl_attr attr;
+    
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE_POLICY;
+    attr.sched_runtime = runtime;
+    attr.sched_deadline = deadline;
+    attr.sched_period = period;
+    attr.sched_flags = flags;
+    
+    return syscall(SYS_sched_setattr, tid, &attr, 0);
+}
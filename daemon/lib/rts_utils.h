@@ -4,6 +4,7 @@
 
 #include <time.h>
 #include <stdint.h>
+#include <sys/types.h>
 
 #define _GNU_SOURCE
 
@@ -27,6 +28,8 @@
 #define NANO_TO_MILLI(nano) nano / EXP6
 #define NANO_TO_MICRO(nano) nano / EXP3
 
+void time_add_ns(struct timespec *t, uint64_t ns);
+
 void time_add_us(struct timespec *t, uint64_t us);
 
 void time_add_ms(struct timespec *t, uint32_t ms);
@@ -35,6 +38,10 @@ int time_cmp(struct timespec* t1, struct timespec* t2);
 
 void time_copy(struct timespec* td, struct timespec* ts);
 
+uint64_t timespec_to_ns(struct timespec *t);
+
+void ns_to_timespec(struct timespec *t, uint64_t ns);
+
 uint64_t timespec_to_us(struct timespec *t);
 
 void us_to_timespec(struct timespec *t, uint64_t us);
@@ -49,16 +56,23 @@ void get_time_now2(clockid_t clk, struct timespec* t);
 
 uint32_t get_time_now_ms(clockid_t clk);
 
+uint64_t get_time_now_ns(clockid_t clk);
+
 struct timespec get_thread_time();
 
 uint32_t get_thread_time_ms();
 
+uint64_t get_thread_time_ns();
+
 void compute_for(uint32_t exec_milli_max);
 
 void wait_next_activation(struct timespec* t_act, uint32_t period_milli);
 
 void set_timer(uint32_t milli);
 
+// SCHED_DEADLINE parameters [ns] and flags for thread tid (0 for the caller)
+int set_sched_deadline(pid_t tid, uint64_t runtime, uint64_t deadline, uint64_t period, uint64_t flags);
+
 
 #endif	// RTS_UTILS_H
 
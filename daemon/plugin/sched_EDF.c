@@ -32,7 +32,10 @@
 #endif
 
 #define SCHED_DEADLINE	6
-#define MILLI_TO_NANO(var) var * 1000 * 1000
+#define SCHED_FLAG_DL_OVERRUN	0x04
+
+#define DBF_MAX_POINTS 100000
+#define SPLIT_STEPS 20
 
 struct sched_attr {
 	__u32 size;
@@ -56,27 +59,246 @@ int sched_setattr(pid_t pid, const struct sched_attr *attr, unsigned int flags)
     return syscall(__NR_sched_setattr, pid, attr, flags);
 }
 
-int ts_recalc_utils(struct rts_plugin* this, struct rts_taskset* ts) {
-    iterator_t iterator;
+//----------------------------------------------------------
+// PROCESSOR DEMAND: exact test for constrained deadlines,
+// needed where the pieces of split tasks run (D < T)
+//----------------------------------------------------------
+
+// a task, or a piece of a split task, as seen by one cpu [ns]
+struct dbf_task {
+    double C;
+    double D;
+    double T;
+};
+
+// period and deadline fall back on the estimates, as the utilization does;
+// a task with no period known at all is left to the utilization test
+static double task_period(struct rts_task* t) {
+    return rts_task_get_est_period(t);
+}
+
+static double task_deadline(struct rts_task* t) {
+    double D = rts_task_get_est_deadline(t);
+    
+    return D != 0 && D < task_period(t) ? D : task_period(t);
+}
+
+// per-cpu room of the demand test, kept across tests and grown with the taskset
+struct dbf_buf {
+    struct dbf_task* set;
+    size_t cap;
+};
+
+// per-cpu tests may run in parallel: the first caller publishes the buffers
+static struct dbf_task* dbf_reserve(struct rts_plugin* this, int cpu, size_t n) {
+    void* expected = NULL;
+    void* bufs = __atomic_load_n(&(this->priv), __ATOMIC_ACQUIRE);
+    struct dbf_buf* b;
+    struct dbf_task* set;
+    size_t cap;
+    
+    if(bufs == NULL) {
+        bufs = calloc(this->cpunum, sizeof(struct dbf_buf));
+        
+        if(bufs == NULL)
+            return NULL;
+        
+        if(!__atomic_compare_exchange_n(&(this->priv), &expected, bufs, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(bufs);
+            bufs = expected;
+        }
+    }
+    
+    b = &(((struct dbf_buf*)bufs)[cpu]);
+    
+    if(n <= b->cap)
+        return b->set;
+    
+    for(cap = b->cap > 0 ? b->cap : 16; cap < n; cap *= 2)
+        ;
+    
+    set = realloc(b->set, cap * sizeof(struct dbf_task));
+    
+    if(set == NULL)
+        return NULL;
+    
+    b->set = set;
+    b->cap = cap;
+    return set;
+}
+
+// the edf tasks and pieces on cpu, plus room for the candidate pieces
+static struct dbf_task* dbf_collect(struct rts_plugin* this, struct rts_taskset* ts, int cpu, int extra, int* n) {
     struct rts_task* t;
+    struct dbf_task* set;
+    
+    set = dbf_reserve(this, cpu, extra + ts->size * RTS_SPLIT_MAX);
+    *n = 0;
+    
+    if(set == NULL)
+        return NULL;
     
-    memset(this->util_used_percpu, 0, this->cpunum * sizeof(float));
-    iterator = rts_taskset_iterator_init(ts);
+    // split tasks sit in the partition of their first piece
+    for(int c = 0; c < this->cpunum; c++) {
+        for(int i = rts_taskset_part_first(ts, this->pluginid, c); i != -1; i = rts_taskset_part_next(ts, i)) {
+            t = ts->tasks[i];
+            
+            if(t->nsplit == 0 && c == cpu && task_period(t) > 0) {
+                set[*n].C = ts->util[i] * task_period(t);
+                set[*n].D = task_deadline(t);
+                set[*n].T = task_period(t);
+                (*n)++;
+            }
+            
+            for(uint32_t k = 0; k < t->nsplit; k++) {
+                if((int)t->split_cpu[k] != cpu)
+                    continue;
+                
+                set[*n].C = t->split_runtime[k];
+                set[*n].D = t->split_deadline[k];
+                set[*n].T = t->period;
+                (*n)++;
+            }
+        }
+    }
+    
+    return set;
+}
+
+// sum of dbf(L) <= L at every absolute deadline up to the busy period
+// bound. Gives up (unschedulable) after DBF_MAX_POINTS deadlines.
+static int dbf_test(struct dbf_task* set, int n) {
+    double u = 0, bound = 0, L, next, demand;
+    int constrained = 0;
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
+    for(int i = 0; i < n; i++) {
+        if(set[i].T <= 0 || set[i].C > set[i].D)
+            return 0;
+        
+        u += set[i].C / set[i].T;
+        constrained |= set[i].D < set[i].T;
         
-        if(t->pluginid == this->pluginid)
-            this->util_used_percpu[t->cpu] += rts_task_get_util(t);
+        if(set[i].D > bound)
+            bound = set[i].D;
     }
     
-    for(int i = 0; i < this->cpunum; i++)
-        if(this->util_used_percpu[i] > 1)
-            return -1;
+    if(u > 1)
+        return 0;
+    
+    // implicit deadlines: the utilization bound is exact
+    if(!constrained)
+        return 1;
+    
+    // no bound on the busy period of a full cpu
+    if(u >= 1)
+        return 0;
+    
+    L = 0;
+    
+    for(int i = 0; i < n; i++)
+        L += (set[i].T - set[i].D) * set[i].C / set[i].T;
+    
+    L = L / (1 - u);
+    
+    if(L > bound)
+        bound = L;
+    
+    L = 0;
+    
+    for(int p = 0; p < DBF_MAX_POINTS; p++) {
+        next = -1;
+        
+        // next absolute deadline after L
+        for(int i = 0; i < n; i++) {
+            double d = set[i].D;
+            
+            if(d <= L)
+                d += ((long)((L - set[i].D) / set[i].T) + 1) * set[i].T;
+            
+            if(next < 0 || d < next)
+                next = d;
+        }
+        
+        if(next < 0 || next > bound)
+            return 1;
+        
+        L = next;
+        demand = 0;
+        
+        for(int i = 0; i < n; i++)
+            if(L >= set[i].D)
+                demand += ((long)((L - set[i].D) / set[i].T) + 1) * set[i].C;
+        
+        if(demand > L + 1)
+            return 0;
+    }
     
     return 0;
 }
 
+// can cpu host the extra pieces besides what it already runs. Deadline
+// threads preempt the ones of the other plugins, so these only bound the
+// bandwidth left: within it the edf demand is checked on the whole cpu.
+static int dbf_fits(struct rts_plugin* this, struct rts_taskset* ts, int cpu, float* free_utils, 
+                    struct dbf_task* extra, int nextra) {
+    struct dbf_task* set;
+    float u = 0;
+    int n;
+    
+    for(int i = 0; i < nextra; i++)
+        if(extra[i].T > 0)
+            u += extra[i].C / extra[i].T;
+    
+    if(u > free_utils[cpu])
+        return 0;
+    
+    // no demand to check without a period, the caller tested the utilization
+    for(int i = 0; i < nextra; i++)
+        if(extra[i].T <= 0)
+            return 1;
+    
+    set = dbf_collect(this, ts, cpu, nextra, &n);
+    
+    if(set == NULL)
+        return 0;
+    
+    for(int i = 0; i < nextra; i++)
+        set[n++] = extra[i];
+    
+    return dbf_test(set, n);
+}
+
+void plugin_destroy(struct rts_plugin* this) {
+    struct dbf_buf* b = this->priv;
+    
+    if(b == NULL)
+        return;
+    
+    for(int i = 0; i < this->cpunum; i++)
+        free(b[i].set);
+    
+    free(b);
+    this->priv = NULL;
+}
+
+// fraction of the utilization of t charged to cpu: a split task is charged
+// the runtime of its pieces, guard included
+float t_cpu_share(struct rts_plugin* this, struct rts_task* t, int cpu) {
+    float share = 0;
+    
+    if(t->nsplit == 0)
+        return (int)t->cpu == cpu ? 1 : 0;
+    
+    if(rts_task_get_util(t) <= 0)
+        return 0;
+    
+    for(uint32_t k = 0; k < t->nsplit; k++)
+        if((int)t->split_cpu[k] == cpu)
+            share += t->split_runtime[k] / (double)t->period / rts_task_get_util(t);
+    
+    return share;
+}
+
 void ts_recalc_prios(struct rts_plugin* this, struct rts_taskset* ts) {
     return;
 }
@@ -95,10 +317,16 @@ int t_schedule(struct rts_task* t) {
     attr.size = sizeof(attr);
 
     attr.sched_policy = SCHED_DEADLINE;
-    attr.sched_runtime = MILLI_TO_NANO(rts_task_get_wcet(t));
-    attr.sched_deadline = MILLI_TO_NANO(rts_task_get_deadline(t));
-    attr.sched_period = MILLI_TO_NANO(rts_task_get_period(t));
-    attr.sched_flags = 0;
+    attr.sched_runtime = rts_task_get_wcet(t);
+    attr.sched_deadline = rts_task_get_deadline(t);
+    attr.sched_period = rts_task_get_period(t);
+    
+    // a split task starts from its first piece, the thread moves on by itself
+    if(t->nsplit > 0) {
+        attr.sched_runtime = t->split_runtime[0];
+        attr.sched_deadline = t->split_deadline[0];
+    }
+    attr.sched_flags = t->flags & RTS_RSV_NOTIFY_OVERRUN ? SCHED_FLAG_DL_OVERRUN : 0;
     attr.sched_nice = 0;
     attr.sched_priority = 0;
         
@@ -129,11 +357,23 @@ int t_deschedule(struct rts_task* t) {
 }
 
 void t_add_to_utils(struct rts_plugin* this, struct rts_task* t) {
-    this->util_used_percpu[t->cpu] += rts_task_get_util(t);
+    if(t->nsplit == 0) {
+        this->util_used_percpu[t->cpu] += rts_task_get_util(t);
+        return;
+    }
+    
+    for(uint32_t k = 0; k < t->nsplit; k++)
+        this->util_used_percpu[t->split_cpu[k]] += rts_task_get_util(t) * t_cpu_share(this, t, t->split_cpu[k]);
 }
 
 void t_remove_from_utils(struct rts_plugin* this, struct rts_task* t) {
-    this->util_used_percpu[t->cpu] -= rts_task_get_util(t);
+    if(t->nsplit == 0) {
+        this->util_used_percpu[t->cpu] -= rts_task_get_util(t);
+        return;
+    }
+    
+    for(uint32_t k = 0; k < t->nsplit; k++)
+        this->util_used_percpu[t->split_cpu[k]] -= rts_task_get_util(t) * t_cpu_share(this, t, t->split_cpu[k]);
 }
 
 int t_recalc_util(struct rts_plugin* this, struct rts_task* t) {
@@ -144,6 +384,10 @@ int t_recalc_util(struct rts_plugin* this, struct rts_task* t) {
     if(this->util_used_percpu[t->cpu] > 1)
         return -1;
     
+    for(uint32_t k = 0; k < t->nsplit; k++)
+        if(this->util_used_percpu[t->split_cpu[k]] > 1)
+            return -1;
+    
     return 0;
 }
 
@@ -151,23 +395,21 @@ void t_calc_prio(struct rts_plugin* this, struct rts_taskset* ts, struct rts_tas
     return;
 }
 
-float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) { 
+float t_test_cpu(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, int cpu, float* free_utils) { 
     int required;
     int got;
-    float task_util;
-    int free_cpu = -1;
+    struct dbf_task piece;
     
-    task_util = rts_task_get_util(t);
+    if(rts_task_get_util(t) > free_utils[cpu])
+        return 0;
     
-    for(int i = 0; i < this->cpunum && free_cpu == -1; i++)
-        if(task_util <= free_utils[i])
-            free_cpu = i;
+    piece.C = rts_task_get_util(t) * task_period(t);
+    piece.D = task_deadline(t);
+    piece.T = task_period(t);
     
-    if(free_cpu == -1)
+    if(!dbf_fits(this, ts, cpu, free_utils, &piece, 1))
         return 0;
     
-    t->cpu = free_cpu;
-    
     got = 0;
     required = 3;
     
@@ -180,3 +422,112 @@ float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t
     
     return (got/ (float)required);
 }
+
+float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
+    float score;
+    
+    for(int i = 0; i < this->cpunum; i++) {
+        score = t_test_cpu(this, ts, t, i, free_utils);
+        
+        if(score > 0) {
+            t->cpu = i;
+            return score;
+        }
+    }
+    
+    return 0;
+}
+
+// C=D splitting: while the rest of the task fits no free cpu, the cpu that
+// takes the longest zero laxity piece (runtime = deadline) runs it first,
+// then the rest goes on with the deadline left. Pieces include the guard
+// runtime the thread leaves unused to move on in time.
+float t_test_split(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
+    int k, c, best, taken;
+    double lo, hi, mid, best_C;
+    double C, D, G;
+    struct dbf_task piece;
+    
+    if(t->wcet == 0 || t->period == 0)
+        return 0;
+    
+    C = rts_task_get_util(t) * t->period;
+    D = task_deadline(t);
+    G = RTS_SPLIT_GUARD_NS;
+    
+    for(k = 0; k < RTS_SPLIT_MAX; k++) {
+        piece.T = t->period;
+        
+        // the rest fits whole on a cpu not used yet: last piece
+        for(c = 0; c < this->cpunum; c++) {
+            taken = 0;
+            
+            for(int j = 0; j < k; j++)
+                taken |= (int)t->split_cpu[j] == c;
+            
+            piece.C = C;
+            piece.D = D;
+            
+            if(taken || k == 0 || !dbf_fits(this, ts, c, free_utils, &piece, 1))
+                continue;
+            
+            t->split_cpu[k] = c;
+            t->split_runtime[k] = C;
+            t->split_deadline[k] = D;
+            t->nsplit = k + 1;
+            
+            // wcet and period are set
+            return t->deadline != 0 ? 1 : 2 / (float)3;
+        }
+        
+        if(k == RTS_SPLIT_MAX - 1)
+            break;
+        
+        // longest zero laxity piece some cpu accepts
+        best = -1;
+        best_C = 0;
+        
+        for(c = 0; c < this->cpunum; c++) {
+            taken = 0;
+            
+            for(int j = 0; j < k; j++)
+                taken |= (int)t->split_cpu[j] == c;
+            
+            if(taken)
+                continue;
+            
+            lo = 0;
+            hi = C < D - G ? C : D - G;
+            
+            for(int i = 0; i < SPLIT_STEPS && hi > 0; i++) {
+                mid = (lo + hi) / 2;
+                piece.C = mid + G;
+                piece.D = mid + G;
+                
+                if(dbf_fits(this, ts, c, free_utils, &piece, 1))
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            
+            if(lo > best_C) {
+                best_C = lo;
+                best = c;
+            }
+        }
+        
+        // the rest must still be something to run in some time
+        if(best == -1 || best_C >= C || D - best_C - G <= C - best_C)
+            break;
+        
+        t->split_cpu[k] = best;
+        t->split_runtime[k] = best_C + G;
+        t->split_deadline[k] = best_C + G;
+        
+        C -= best_C;
+        D -= best_C + G;
+    }
+    
+    t->nsplit = 0;
+    return 0;
+}
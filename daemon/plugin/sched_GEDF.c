@@ -0,0 +1,524 @@
+#define _GNU_SOURCE
+
+#include "../lib/rts_taskset.h"
+#include "../lib/rts_plugin.h"
+#include "../lib/rts_config.h"
+#include "../components/logger.h"
+#include <sched.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/unistd.h>
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/sysinfo.h>
+
+
+#ifdef __x86_64__
+    #define __NR_sched_setattr		314
+    #define __NR_sched_getattr		315
+#endif
+
+#ifdef __i386__
+    #define __NR_sched_setattr		351
+    #define __NR_sched_getattr		352
+#endif
+
+#ifdef __arm__
+    #define __NR_sched_setattr		380
+    #define __NR_sched_getattr		381
+#endif
+
+#define SCHED_DEADLINE	6
+#define SCHED_FLAG_DL_OVERRUN	0x04
+
+#define SYSFS_CPU           "/sys/devices/system/cpu"
+#define SYSFS_NODE          "/sys/devices/system/node"
+#define PROC_RT_RUNTIME     "/proc/sys/kernel/sched_rt_runtime_us"
+#define PATH_MAX_LEN        128
+#define GEDF_CAPACITY_EPS   1e-4
+
+struct sched_attr {
+	__u32 size;
+
+	__u32 sched_policy;
+	__u64 sched_flags;
+
+	/* SCHED_NORMAL, SCHED_BATCH */
+	__s32 sched_nice;
+
+	/* SCHED_FIFO, SCHED_RR */
+	__u32 sched_priority;
+
+	/* SCHED_DEADLINE (nsec) */
+	__u64 sched_runtime;
+	__u64 sched_deadline;
+        __u64 sched_period;
+ };
+
+int sched_setattr(pid_t pid, const struct sched_attr *attr, unsigned int flags) {
+    return syscall(__NR_sched_setattr, pid, attr, flags);
+}
+
+//----------------------------------------------------------
+// TOPOLOGY: cpus are grouped in clusters, each one scheduled
+// by global EDF. A cluster is named after its lowest cpu.
+//----------------------------------------------------------
+
+enum CLUSTER {
+    CLUSTER_GLOBAL,
+    CLUSTER_LLC,
+    CLUSTER_NUMA
+};
+
+struct gedf_topology {
+    enum CLUSTER mode;
+    int ncpu;
+    int* leader;            // cluster of each cpu, -1 if the daemon can't use it
+    int* size;              // number of cpus, valid for leaders
+    cpu_set_t* span;        // cpus of the cluster, valid for leaders
+    cpu_set_t rd_span;      // cpus the daemon may use (root domain)
+};
+
+// t_schedule has no access to the plugin, the topology is per library
+static struct gedf_topology topo;
+
+// "0-3,8,10-11" -> set
+static int parse_cpulist(const char* path, cpu_set_t* set) {
+    FILE* f;
+    char buffer[PATH_MAX_LEN * 2];
+    char* tok;
+    char* save;
+    int first, last;
+    
+    CPU_ZERO(set);
+    f = fopen(path, "r");
+    
+    if(f == NULL)
+        return -1;
+    
+    if(fgets(buffer, sizeof(buffer), f) == NULL) {
+        fclose(f);
+        return -1;
+    }
+    
+    fclose(f);
+    
+    for(tok = strtok_r(buffer, ",\n", &save); tok != NULL; tok = strtok_r(NULL, ",\n", &save)) {
+        if(sscanf(tok, "%d-%d", &first, &last) == 1)
+            last = first;
+        
+        for(int i = first; i <= last && i < CPU_SETSIZE; i++)
+            CPU_SET(i, set);
+    }
+    
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// cpus sharing the last level (non instruction) cache with cpu
+static int read_llc_span(int cpu, cpu_set_t* set) {
+    FILE* f;
+    char path[PATH_MAX_LEN];
+    char type[PATH_MAX_LEN];
+    int level, llc_level, llc_index;
+    
+    llc_level = -1;
+    llc_index = -1;
+    
+    for(int i = 0; ; i++) {
+        snprintf(path, PATH_MAX_LEN, SYSFS_CPU "/cpu%d/cache/index%d/level", cpu, i);
+        f = fopen(path, "r");
+        
+        if(f == NULL)
+            break;
+        
+        if(fscanf(f, "%d", &level) != 1)
+            level = -1;
+        
+        fclose(f);
+        
+        snprintf(path, PATH_MAX_LEN, SYSFS_CPU "/cpu%d/cache/index%d/type", cpu, i);
+        f = fopen(path, "r");
+        
+        if(f == NULL)
+            continue;
+        
+        if(fscanf(f, "%127s", type) != 1)
+            type[0] = '\0';
+        
+        fclose(f);
+        
+        if(strcmp(type, "Instruction") && level > llc_level) {
+            llc_level = level;
+            llc_index = i;
+        }
+    }
+    
+    if(llc_index < 0)
+        return -1;
+    
+    snprintf(path, PATH_MAX_LEN, SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, llc_index);
+    return parse_cpulist(path, set);
+}
+
+// cpus of the numa node holding cpu
+static int read_numa_span(int cpu, cpu_set_t* set) {
+    DIR* dir;
+    struct dirent* entry;
+    char path[PATH_MAX_LEN];
+    int node = -1;
+    
+    snprintf(path, PATH_MAX_LEN, SYSFS_CPU "/cpu%d", cpu);
+    dir = opendir(path);
+    
+    if(dir == NULL)
+        return -1;
+    
+    while((entry = readdir(dir)) != NULL)
+        if(sscanf(entry->d_name, "node%d", &node) == 1)
+            break;
+    
+    closedir(dir);
+    
+    if(node < 0)
+        return -1;
+    
+    snprintf(path, PATH_MAX_LEN, SYSFS_NODE "/node%d/cpulist", node);
+    return parse_cpulist(path, set);
+}
+
+static int topology_build(struct gedf_topology* tp) {
+    int c, l;
+    int ret;
+    cpu_set_t set;
+    
+    for(c = 0; c < tp->ncpu; c++) {
+        tp->leader[c] = -1;
+        tp->size[c] = 0;
+        CPU_ZERO(&(tp->span[c]));
+    }
+    
+    for(c = 0; c < tp->ncpu; c++) {
+        if(!CPU_ISSET(c, &(tp->rd_span)) || tp->leader[c] != -1)
+            continue;
+        
+        switch(tp->mode) {
+            case CLUSTER_LLC:
+                ret = read_llc_span(c, &set);
+                break;
+            case CLUSTER_NUMA:
+                ret = read_numa_span(c, &set);
+                break;
+            default:
+                set = tp->rd_span;
+                ret = 0;
+        }
+        
+        if(ret < 0)
+            return -1;
+        
+        CPU_AND(&set, &set, &(tp->rd_span));
+        
+        // c is the lowest usable cpu not yet clustered, hence the leader
+        for(l = 0; l < tp->ncpu; l++) {
+            if(!CPU_ISSET(l, &set) || tp->leader[l] != -1)
+                continue;
+            
+            tp->leader[l] = c;
+            tp->size[c]++;
+            CPU_SET(l, &(tp->span[c]));
+        }
+    }
+    
+    return 0;
+}
+
+static int cluster_of(int cpu) {
+    return cpu >= 0 && cpu < topo.ncpu ? topo.leader[cpu] : -1;
+}
+
+static int in_cluster(int cpu, int leader) {
+    return leader != -1 && cluster_of(cpu) == leader;
+}
+
+// density (C / min(D, T)), the utilization for implicit deadlines
+static float density(float util, uint64_t deadline, uint64_t period) {
+    return deadline != 0 && deadline < period ? util * (double)period / deadline : util;
+}
+
+static float gedf_density(struct rts_task* t) {
+    return density(rts_task_get_util(t), t->deadline, t->period);
+}
+
+// total and largest density of the tasks of cluster leader
+static void cluster_load(struct rts_plugin* this, struct rts_taskset* ts, int leader, float* sum, float* max) {
+    float d;
+    
+    *sum = 0;
+    *max = 0;
+    
+    for(int c = 0; c < topo.ncpu; c++) {
+        if(!in_cluster(c, leader))
+            continue;
+        
+        for(int i = rts_taskset_part_first(ts, this->pluginid, c); i != -1; i = rts_taskset_part_next(ts, i)) {
+            d = density(ts->util[i], ts->deadline[i], ts->period[i]);
+            *sum += d;
+            
+            if(d > *max)
+                *max = d;
+        }
+    }
+}
+
+// Goossens-Funk-Baruah: global EDF meets every deadline on m cpus if
+// sum <= m - (m - 1) * max. It holds for m whole cpus only, so the
+// cpus of the cluster must carry no task of the other plugins; a cpu
+// throttled to a capacity s < 1 is a cpu of speed s, and m * s takes
+// the place of m in the first term.
+static int gfb_test(float sum, float max, float capacity, int m) {
+    return max <= 1 && sum <= capacity - (m - 1) * max;
+}
+
+// with bandwidth control on, the kernel accepts SCHED_DEADLINE only for
+// threads allowed on the whole root domain
+static int dl_bw_enabled() {
+    FILE* f;
+    int runtime = -1;
+    
+    f = fopen(PROC_RT_RUNTIME, "r");
+    
+    if(f == NULL)
+        return 1;
+    
+    if(fscanf(f, "%d", &runtime) != 1)
+        runtime = 0;
+    
+    fclose(f);
+    return runtime != -1;
+}
+
+int plugin_init(struct rts_plugin* this) {
+    struct rts_config cfg;
+    const char* mode;
+    
+    topo.ncpu = this->cpunum < CPU_SETSIZE ? this->cpunum : CPU_SETSIZE;
+    topo.leader = calloc(topo.ncpu, sizeof(int));
+    topo.size = calloc(topo.ncpu, sizeof(int));
+    topo.span = calloc(topo.ncpu, sizeof(cpu_set_t));
+    
+    if(topo.leader == NULL || topo.size == NULL || topo.span == NULL)
+        return -1;
+    
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &(topo.rd_span)) < 0) {
+        CPU_ZERO(&(topo.rd_span));
+        
+        for(int i = 0; i < topo.ncpu; i++)
+            CPU_SET(i, &(topo.rd_span));
+    }
+    
+    rts_config_load(&cfg, PLUGIN_CFG);
+    mode = rts_config_get_str(&cfg, "gedf_cluster", "GLOBAL");
+    
+    if(!strcmp(mode, "LLC"))
+        topo.mode = CLUSTER_LLC;
+    else if(!strcmp(mode, "NUMA"))
+        topo.mode = CLUSTER_NUMA;
+    else
+        topo.mode = CLUSTER_GLOBAL;
+    
+    // the threads of a cluster could not be confined to it: the bound of
+    // each cluster would not hold on the whole domain
+    if(topo.mode != CLUSTER_GLOBAL && dl_bw_enabled()) {
+        LOG("GEDF: gedf_cluster %s needs SCHED_DEADLINE bandwidth control off, GLOBAL is used.\n", mode);
+        topo.mode = CLUSTER_GLOBAL;
+    }
+    
+    // without topology information the whole domain is one cluster
+    if(topology_build(&topo) < 0) {
+        topo.mode = CLUSTER_GLOBAL;
+        topology_build(&topo);
+    }
+    
+    this->priv = &topo;
+    return 0;
+}
+
+void plugin_destroy(struct rts_plugin* this) {
+    free(topo.leader);
+    free(topo.size);
+    free(topo.span);
+    
+    topo.leader = NULL;
+    topo.size = NULL;
+    topo.span = NULL;
+    this->priv = NULL;
+}
+
+void ts_recalc_prios(struct rts_plugin* this, struct rts_taskset* ts) {
+    return;
+}
+
+int t_schedule(struct rts_task* t) {
+    struct sched_attr attr;
+    cpu_set_t* my_set;
+    
+    if(cluster_of(t->cpu) == -1)
+        return -1;
+    
+    my_set = &(topo.span[cluster_of(t->cpu)]);
+    
+    // bandwidth control turned on after plugin_init: the kernel would only
+    // take the thread on the whole domain, where its admission does not hold
+    if(dl_bw_enabled() && !CPU_EQUAL(my_set, &(topo.rd_span)))
+        return -1;
+    
+    if(sched_setaffinity(t->tid, sizeof(cpu_set_t), my_set) < 0)
+        return -1;
+    
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    
+    attr.sched_policy = SCHED_DEADLINE;
+    attr.sched_runtime = rts_task_get_wcet(t);
+    attr.sched_deadline = rts_task_get_deadline(t);
+    attr.sched_period = rts_task_get_period(t);
+    attr.sched_flags = t->flags & RTS_RSV_NOTIFY_OVERRUN ? SCHED_FLAG_DL_OVERRUN : 0;
+    attr.sched_nice = 0;
+    attr.sched_priority = 0;
+    
+    if(sched_setattr(t->tid, &attr, 0) < 0)
+        return -1;
+    
+    return 0;
+}
+
+int t_deschedule(struct rts_task* t) {
+    struct sched_param attr;
+    cpu_set_t my_set;
+    
+    CPU_ZERO(&my_set);
+    
+    for(int i = 0; i < get_nprocs(); i++)
+        CPU_SET(i, &my_set);
+    
+    if(sched_setaffinity(t->tid, sizeof(cpu_set_t), &my_set) < 0)
+        return -1;
+    
+    attr.sched_priority = 0;
+    
+    if(sched_setscheduler(t->tid, SCHED_OTHER, &attr) < 0)
+        return -1;
+    
+    return 0;
+}
+
+// t->cpu names the cluster, the utilization is spread over its cpus
+float t_cpu_share(struct rts_plugin* this, struct rts_task* t, int cpu) {
+    int leader = cluster_of(t->cpu);
+    
+    if(!in_cluster(cpu, leader))
+        return 0;
+    
+    return 1 / (float)topo.size[leader];
+}
+
+void t_add_to_utils(struct rts_plugin* this, struct rts_task* t) {
+    for(int i = 0; i < topo.ncpu; i++)
+        this->util_used_percpu[i] += rts_task_get_util(t) * t_cpu_share(this, t, i);
+}
+
+void t_remove_from_utils(struct rts_plugin* this, struct rts_task* t) {
+    for(int i = 0; i < topo.ncpu; i++)
+        this->util_used_percpu[i] -= rts_task_get_util(t) * t_cpu_share(this, t, i);
+}
+
+// the taskset is not available here: only the necessary condition (the
+// cluster is not overloaded) is checked on refresh, GFB runs at admission
+// and when a budget grows
+int t_recalc_util(struct rts_plugin* this, struct rts_task* t) {
+    int leader = cluster_of(t->cpu);
+    float sum = 0;
+    
+    this->t_remove_from_utils(this, t);
+    rts_task_update_util(t);
+    this->t_add_to_utils(this, t);
+    
+    for(int i = 0; i < topo.ncpu; i++)
+        if(in_cluster(i, leader))
+            sum += this->util_used_percpu[i];
+    
+    if(leader == -1 || gedf_density(t) > 1 || sum > topo.size[leader])
+        return -1;
+    
+    return 0;
+}
+
+void t_calc_prio(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t) {
+    return;
+}
+
+// only the leader of a cluster answers, for the cluster as a whole
+float t_test_cpu(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, int cpu, float* free_utils) {
+    int required;
+    int got;
+    float sum, max, capacity;
+    
+    if(cluster_of(cpu) != cpu)
+        return 0;
+    
+    cluster_load(this, ts, cpu, &sum, &max);
+    
+    sum += gedf_density(t);
+    
+    if(gedf_density(t) > max)
+        max = gedf_density(t);
+    
+    capacity = 0;
+    
+    // see gfb_test: a cpu with load of other plugins fails the cluster
+    for(int i = 0; i < topo.ncpu; i++) {
+        if(!in_cluster(i, cpu))
+            continue;
+        
+        if(free_utils[i] + this->util_used_percpu[i] < this->cpu_capacity - GEDF_CAPACITY_EPS)
+            return 0;
+        
+        capacity += this->cpu_capacity;
+    }
+    
+    if(!gfb_test(sum, max, capacity, topo.size[cpu]))
+        return 0;
+    
+    got = 0;
+    required = 3;
+    
+    if(t->wcet != 0)
+        got++;
+    if(t->period != 0)
+        got++;
+    if(t->deadline != 0)
+        got++;
+    
+    return (got/ (float)required);
+}
+
+float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
+    float score;
+    
+    for(int i = 0; i < topo.ncpu; i++) {
+        score = t_test_cpu(this, ts, t, i, free_utils);
+        
+        if(score > 0) {
+            t->cpu = i;
+            return score;
+        }
+    }
+    
+    return 0;
+}
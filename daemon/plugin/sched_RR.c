@@ -9,10 +9,7 @@
 #define MIN(val1, val2) (val1 < val2 ? val1 : val2)
 #define MAX(val1, val2) (val1 > val2 ? val1 : val2)
 
-void get_prio_bound(struct rts_taskset* ts, int pluginid, uint32_t* min, uint32_t* max) {
-    struct rts_task* t;
-    iterator_t iterator;
-    
+void get_prio_bound(struct rts_taskset* ts, int pluginid, int ncpu, uint32_t* min, uint32_t* max) {
     if(rts_taskset_is_empty(ts)) {
         *min = 1;
         *max = 99;
@@ -22,14 +19,10 @@ void get_prio_bound(struct rts_taskset* ts, int pluginid, uint32_t* min, uint32_
     *min = UINT32_MAX;
     *max = 0;
     
-    iterator = rts_taskset_iterator_init(ts);
-    
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        
-        if(t->pluginid == pluginid) {
-            *min = MIN(*min, t->priority);
-            *max = MAX(*max, t->priority);
+    for(int c = 0; c < ncpu; c++) {
+        for(int i = rts_taskset_part_first(ts, pluginid, c); i != -1; i = rts_taskset_part_next(ts, i)) {
+            *min = MIN(*min, ts->priority[i]);
+            *max = MAX(*max, ts->priority[i]);
         }   
     }
 }
@@ -45,43 +38,19 @@ uint32_t prio_remap(uint32_t max_prio_s, uint32_t min_prio_s, uint32_t max_prio_
     return min_prio_s + slope * (prio - min_prio_u);
 }
 
-int ts_recalc_utils(struct rts_plugin* this, struct rts_taskset* ts) {
-    iterator_t iterator;
-    struct rts_task* t;
-    
-    memset(this->util_used_percpu, 0, this->cpunum * sizeof(float));
-    iterator = rts_taskset_iterator_init(ts);
-    
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        
-        if(t->pluginid == this->pluginid)
-            this->util_used_percpu[t->cpu] += rts_task_get_util(t);
-    }
-    
-    for(int i = 0; i < this->cpunum; i++)
-        if(this->util_used_percpu[i] > 1)
-            return -1;
-    
-    return 0;
-}
-
 void ts_recalc_prios(struct rts_plugin* this, struct rts_taskset* ts) {
-    iterator_t iterator;
     struct rts_task* t;
     
     uint32_t max_prio_user;
     uint32_t min_prio_user;
     
-    iterator = rts_taskset_iterator_init(ts);
-    get_prio_bound(ts, this->pluginid, &min_prio_user, &max_prio_user);
+    get_prio_bound(ts, this->pluginid, this->cpunum, &min_prio_user, &max_prio_user);
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        
-        if(t->pluginid == this->pluginid)
+    for(int c = 0; c < this->cpunum; c++) {
+        for(int i = rts_taskset_part_first(ts, this->pluginid, c); i != -1; i = rts_taskset_part_next(ts, i)) {
+            t = ts->tasks[i];
             t->schedprio = prio_remap(this->prio_max, this->prio_min, max_prio_user, min_prio_user, t->priority);
-        
+        }
     }
 }
 
@@ -146,17 +115,20 @@ void t_calc_prio(struct rts_plugin* this, struct rts_taskset* ts, struct rts_tas
     uint32_t max_prio_user;
     uint32_t min_prio_user;
     
-    get_prio_bound(ts, this->pluginid, &min_prio_user, &max_prio_user);
+    get_prio_bound(ts, this->pluginid, this->cpunum, &min_prio_user, &max_prio_user);
     t->schedprio = prio_remap(this->prio_max, this->prio_min, max_prio_user, min_prio_user, t->priority);
 }
 
-float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
-    float task_util;
-    
-    task_util = rts_task_get_util(t);
+float t_test_cpu(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, int cpu, float* free_utils) {
+    if(rts_task_get_util(t) > free_utils[cpu])
+        return 0;
     
+    return 1;
+}
+
+float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
     for(int i = 0; i < this->cpunum; i++) {
-        if(task_util <= free_utils[i]) {
+        if(t_test_cpu(this, ts, t, i, free_utils) > 0) {
             t->cpu = i;
             return 1;
         }
@@ -1,149 +1,299 @@
 #define _GNU_SOURCE
 
 #include "../lib/rts_taskset.h"
-#include "../components/list_int.h"
 #include <sched.h>
 #include <stdlib.h>
-#include <float.h>
 #include <stdint.h>
-#include <math.h>
 #include <string.h>
 #include <sys/sysinfo.h>
 
 //----------------------------------------------------------
-// WORKLOAD ANALYSIS: perform the sched. analysis under fp
+// RESPONSE TIME ANALYSIS: exact sched. analysis under fp
 //----------------------------------------------------------
 
-int cmp(int elem1, int elem2) {
-    if(elem1 > elem2)
-        return 1;
-    else if(elem1 < elem2)
-        return -1;
+// One entry per admitted task, kept in rate monotonic order
+struct rta_entry {
+    rsv_t id;
+    uint64_t C;
+    uint64_t T;
+    uint64_t D;
+    uint64_t R;     // response time, valid while the cache is
+};
+
+// Per-cpu cache of the partition and of the last admission test
+struct rta_cpu {
+    int valid;
+    int n;
+    int cap;
+    struct rta_entry* e;
     
-    return 0;
-}
+    rsv_t pend_id;      // candidate of the last successful test
+    int pend_pos;       // position where it would be inserted
+    uint64_t* pend_R;   // response times from pend_pos on, candidate first
+};
 
-unsigned int workload_function(struct rts_taskset* ts, unsigned int i, unsigned int t) {
-    struct rts_task* tj;
-    unsigned int j, res;
+static uint64_t div_ceil(uint64_t a, uint64_t b) {
+    return (a + b - 1) / b;
+}
 
-    res = rts_taskset_get_i_task(ts, i)->wcet;
+// C, T and D fall back on the estimates, as the utilization does
+static uint64_t rta_deadline(struct rts_task* t) {
+    return rts_task_get_est_deadline(t);
+}
 
-    for (j = 0; j < i; j++) {
-        tj = rts_taskset_get_i_task(ts, j);
-        res += (unsigned int) ceil((double) t / tj->period) * tj->wcet;
+// Least fixed point of R = C + sum(ceil(R/Tj) Cj) over hp, starting from r0
+// (any value not above the solution). Returns 0 if R exceeds D.
+static uint64_t rta_response(struct rta_entry* hp, int nhp, struct rta_entry* cand, 
+                             uint64_t C, uint64_t D, uint64_t r0) {
+    uint64_t r, next;
+    
+    r = r0;
+    
+    while(1) {
+        next = C;
+        
+        for(int j = 0; j < nhp; j++)
+            next += div_ceil(r, hp[j].T) * hp[j].C;
+        
+        if(cand != NULL)
+            next += div_ceil(r, cand->T) * cand->C;
+        
+        if(next > D)
+            return 0;
+        
+        if(next == r)
+            return r;
+        
+        r = next;
     }
-
-
-    return res;
 }
 
-// Calculate testing set points BB04
-int testing_set_fp(struct rts_taskset* ts, struct list_int* points, unsigned int i) {
-    unsigned int tj_period, ti_deadline;
-    unsigned int j, k = 0;
-
-    if (i >= rts_taskset_get_size(ts))
-            return -1;
-
-    ti_deadline = rts_taskset_get_i_task(ts, i)->deadline;
-    list_int_add_top(points, ti_deadline);
-
-    for (j = 0; j < i; j++) {
-        k = 1;
-        tj_period = rts_taskset_get_i_task(ts, j)->period;
-
-        while (k * tj_period < ti_deadline) {
-            if(list_int_search_elem(points, k * tj_period) == NULL)
-                list_int_add_sorted(points, k * tj_period, cmp);
-            k++;
+// per-cpu tests may run in parallel: the first caller publishes the cache
+static struct rta_cpu* rta_get(struct rts_plugin* this, int cpu) {
+    void* expected = NULL;
+    void* cache = __atomic_load_n(&(this->priv), __ATOMIC_ACQUIRE);
+    
+    if(cache == NULL) {
+        cache = calloc(this->cpunum, sizeof(struct rta_cpu));
+        
+        if(cache == NULL)
+            return NULL;
+        
+        if(!__atomic_compare_exchange_n(&(this->priv), &expected, cache, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            free(cache);
+            cache = expected;
         }
     }
-
-    return list_int_get_size(points);
+    
+    return &(((struct rta_cpu*)cache)[cpu]);
 }
 
-// da riscrivere con accesso lineare!!!!!!!
-
-unsigned int workload_analysis(struct rts_taskset* ts) {
-    struct list_int points;
-    int n_points, j, jth_point;
-    unsigned int i, is_schedulable = 0;
-
-    list_int_init(&points);
-
-    for(i = 0; i < rts_taskset_get_size(ts); i++) {
-
-        is_schedulable = 0;
-        n_points = testing_set_fp(ts, &points, i);
-
-        if(n_points > 0) {
+static void rta_invalidate(struct rts_plugin* this, int cpu) {
+    struct rta_cpu* rc;
+    
+    if(this->priv == NULL)
+        return;
+    
+    rc = &(((struct rta_cpu*)this->priv)[cpu]);
+    rc->valid = 0;
+    rc->pend_id = -1;
+}
 
-            for (j = 0; j < n_points; j++) {
-                jth_point = *(list_int_get_i_elem(&points, j));
-                if (workload_function(ts, i, jth_point) <= jth_point)
-                    is_schedulable = 1;
-            }
+static int rta_reserve(struct rta_cpu* rc, int n) {
+    struct rta_entry* e;
+    uint64_t* r;
+    int cap;
+    
+    if(n <= rc->cap)
+        return 0;
+    
+    cap = rc->cap ? rc->cap : 16;
+    
+    while(cap < n)
+        cap *= 2;
+    
+    e = realloc(rc->e, cap * sizeof(struct rta_entry));
+    
+    if(e == NULL)
+        return -1;
+    
+    rc->e = e;
+    r = realloc(rc->pend_R, (cap + 1) * sizeof(uint64_t));
+    
+    if(r == NULL)
+        return -1;
+    
+    rc->pend_R = r;
+    rc->cap = cap;
+    return 0;
+}
 
-            if(!is_schedulable)
-                    break;
-        }
+// first position whose period is greater than T: equal periods keep arrival order
+static int rta_position(struct rta_cpu* rc, uint64_t T) {
+    int lo = 0, hi = rc->n;
+    
+    while(lo < hi) {
+        int mid = (lo + hi) / 2;
+        
+        if(rc->e[mid].T <= T)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-
-    return is_schedulable;
+    
+    return lo;
 }
 
-unsigned int hyperbolic_bound(struct rts_taskset* ts) {
-    float res;
-    iterator_t iterator;
-    struct rts_task* t;
+static void rta_insert(struct rta_cpu* rc, int pos, struct rts_task* t, uint64_t R) {
+    memmove(&(rc->e[pos + 1]), &(rc->e[pos]), (rc->n - pos) * sizeof(struct rta_entry));
+    rc->e[pos].id = t->id;
+    rc->e[pos].C = rts_task_get_est_wcet(t);
+    rc->e[pos].T = rts_task_get_est_period(t);
+    rc->e[pos].D = rta_deadline(t);
+    rc->e[pos].R = R;
+    rc->n++;
+}
 
-    res = 1;
-    iterator = rts_taskset_iterator_init(ts);
+// rebuild the partition of cpu from the taskset, skipping the candidate
+static int rta_build(struct rts_plugin* this, struct rta_cpu* rc, struct rts_taskset* ts, 
+                     struct rts_task* cand, int cpu) {
+    struct rta_entry* e;
+    
+    rc->n = 0;
+    rc->pend_id = -1;
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        res *= (t->wcet / (float)t->period) + 1;
+    for(int i = rts_taskset_part_first(ts, this->pluginid, cpu); i != -1; i = rts_taskset_part_next(ts, i)) {
+        // without a period it was admitted on the utilization alone
+        if(ts->tasks[i] == cand || rts_task_get_est_period(ts->tasks[i]) == 0)
+            continue;
+        
+        if(rta_reserve(rc, rc->n + 1) < 0)
+            return -1;
+        
+        rta_insert(rc, rta_position(rc, rts_task_get_est_period(ts->tasks[i])), ts->tasks[i], 0);
     }
+    
+    // a task missing its deadline gets R > D, so no candidate can go above it
+    for(int k = 0; k < rc->n; k++) {
+        e = &(rc->e[k]);
+        
+        if(e->C == 0) {
+            e->R = 0;
+            continue;
+        }
+        
+        e->R = rta_response(rc->e, k, NULL, e->C, e->D, e->C);
+        
+        if(e->R == 0)
+            e->R = e->D + 1;
+    }
+    
+    rc->valid = 1;
+    return 0;
+}
 
-    if(res > 2)
+// Exact test of cand on cpu. Tasks with higher priority keep their
+// response times, the others restart from the old ones plus C of cand.
+static int rta_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* cand, int cpu) {
+    int pos;
+    uint64_t R;
+    struct rta_cpu* rc;
+    struct rta_entry c;
+    
+    if(rts_task_get_est_period(cand) == 0)
         return 0;
-
+    
+    rc = rta_get(this, cpu);
+    
+    if(rc == NULL)
+        return 0;
+    
+    rc->pend_id = -1;
+    
+    if(!rc->valid && rta_build(this, rc, ts, cand, cpu) < 0)
+        return 0;
+    
+    if(rc->n + 1 > (this->prio_max - this->prio_min + 1))
+        return 0;
+    
+    if(rta_reserve(rc, rc->n + 1) < 0)
+        return 0;
+    
+    c.C = rts_task_get_est_wcet(cand);
+    c.T = rts_task_get_est_period(cand);
+    c.D = rta_deadline(cand);
+    pos = rta_position(rc, c.T);
+    
+    // without execution time the candidate delays nobody
+    R = c.C == 0 ? 0 : rta_response(rc->e, pos, NULL, c.C, c.D, c.C);
+    
+    if(R == 0 && c.C != 0)
+        return 0;
+    
+    rc->pend_R[0] = R;
+    
+    for(int k = pos; k < rc->n; k++) {
+        // nothing delays a task without execution time, nor is delayed by it
+        if(c.C == 0 || rc->e[k].C == 0) {
+            rc->pend_R[k - pos + 1] = rc->e[k].R;
+            continue;
+        }
+        
+        R = rta_response(rc->e, k, &c, rc->e[k].C, rc->e[k].D, rc->e[k].R + c.C);
+        
+        if(R == 0)
+            return 0;
+        
+        rc->pend_R[k - pos + 1] = R;
+    }
+    
+    rc->pend_id = cand->id;
+    rc->pend_pos = pos;
     return 1;
 }
 
-void sort_taskset(struct rts_plugin* this, struct rts_taskset* ts, struct rts_taskset* ts_ssrm, int cpu) {
-    struct rts_task* t;
-    iterator_t iterator;
+// make cand part of the cached partition using the results of its test
+static void rta_commit(struct rts_plugin* this, struct rts_task* t) {
+    struct rta_cpu* rc;
+    int pos;
     
-    iterator = rts_taskset_iterator_init(ts);
+    if(this->priv == NULL)
+        return;
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        if(t->pluginid == this->pluginid && t->cpu == cpu)
-            rts_taskset_add_sorted_pr(ts_ssrm, t);
+    rc = &(((struct rta_cpu*)this->priv)[t->cpu]);
+    
+    if(!rc->valid || rc->pend_id != t->id) {
+        rta_invalidate(this, t->cpu);
+        return;
     }
+    
+    pos = rc->pend_pos;
+    rta_insert(rc, pos, t, rc->pend_R[0]);
+    
+    for(int k = pos + 1; k < rc->n; k++)
+        rc->e[k].R = rc->pend_R[k - pos];
+    
+    rc->pend_id = -1;
 }
 
-int ts_recalc_utils(struct rts_plugin* this, struct rts_taskset* ts) {
-    iterator_t iterator;
-    struct rts_task* t;
+void plugin_destroy(struct rts_plugin* this) {
+    struct rta_cpu* rc = this->priv;
     
-    memset(this->util_used_percpu, 0, this->cpunum * sizeof(float));
-    iterator = rts_taskset_iterator_init(ts);
+    if(rc == NULL)
+        return;
     
-    for(; iterator != NULL; iterator = iterator_get_next(iterator)) {
-        t = rts_taskset_iterator_get_elem(iterator);
-        
-        if(t->pluginid == this->pluginid)
-            this->util_used_percpu[t->cpu] += rts_task_get_util(t);
+    for(int i = 0; i < this->cpunum; i++) {
+        free(rc[i].e);
+        free(rc[i].pend_R);
     }
     
-    for(int i = 0; i < this->cpunum; i++)
-        if(this->util_used_percpu[i] > 1)
-            return -1;
-    
-    return 0;
+    free(rc);
+    this->priv = NULL;
+}
+
+void sort_taskset(struct rts_plugin* this, struct rts_taskset* ts, struct rts_taskset* ts_ssrm, int cpu) {
+    for(int i = rts_taskset_part_first(ts, this->pluginid, cpu); i != -1; i = rts_taskset_part_next(ts, i))
+        rts_taskset_add_sorted_pr(ts_ssrm, ts->tasks[i]);
 }
 
 void ts_recalc_prios(struct rts_plugin* this, struct rts_taskset* ts) {
@@ -153,17 +303,19 @@ void ts_recalc_prios(struct rts_plugin* this, struct rts_taskset* ts) {
     unsigned int priority;
     
     for(int i = 0; i < this->cpunum; i++) {
-        rts_taskset_init(&ts_ssrm);
+        rts_taskset_init_arena(&ts_ssrm, this->scratch);
         sort_taskset(this, ts, &ts_ssrm, i);
     
         iterator = rts_taskset_iterator_init(&ts_ssrm);
         priority = this->prio_max;
 
-        for (; iterator != NULL; iterator = iterator_get_next(iterator)) {
+        for (; iterator != NULL; iterator = rts_taskset_iterator_get_next(iterator)) {
             t_ssrm = rts_taskset_iterator_get_elem(iterator);
             t_ssrm->schedprio = priority;
             priority--;
         }
+        
+        rts_taskset_destroy(&ts_ssrm);
     }
 }
 
@@ -216,10 +368,13 @@ void t_assign_cpu(struct rts_plugin* this, struct rts_task* t, float* free_utils
 }
 
 void t_add_to_utils(struct rts_plugin* this, struct rts_task* t) {
+    rta_commit(this, t);
     this->util_used_percpu[t->cpu] += rts_task_get_util(t);
 }
 
 void t_remove_from_utils(struct rts_plugin* this, struct rts_task* t) {
+    // response times of lower priority tasks shrink: rebuilt on next test
+    rta_invalidate(this, t->cpu);
     this->util_used_percpu[t->cpu] -= rts_task_get_util(t);
 }
 
@@ -242,13 +397,13 @@ void t_calc_prio(struct rts_plugin* this, struct rts_taskset* ts, struct rts_tas
     struct rts_taskset ts_ssrm;
     unsigned int priority;
         
-    rts_taskset_init(&ts_ssrm);
+    rts_taskset_init_arena(&ts_ssrm, this->scratch);
     sort_taskset(this, ts, &ts_ssrm, t->cpu);
     
     iterator = rts_taskset_iterator_init(&ts_ssrm);
     priority = this->prio_max;
 
-    for (; iterator != NULL; iterator = iterator_get_next(iterator)) {
+    for (; iterator != NULL; iterator = rts_taskset_iterator_get_next(iterator)) {
         t_ssrm = rts_taskset_iterator_get_elem(iterator);
         
         if(t_ssrm->id == t->id) {
@@ -258,39 +413,19 @@ void t_calc_prio(struct rts_plugin* this, struct rts_taskset* ts, struct rts_tas
         
         priority--;
     }
+    
+    rts_taskset_destroy(&ts_ssrm);
 }
 
-float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
+float t_test_cpu(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, int cpu, float* free_utils) {
     int got;
     int required;
-    int free_cpu = -1;
-    float task_util;
-    struct rts_taskset ts_ssrm;
     
-    task_util = rts_task_get_util(t);
-       
-    for(int i = 0; i < this->cpunum && free_cpu == -1; i++) {
-        if(task_util > free_utils[i])
-            continue;
-        
-        rts_taskset_init(&ts_ssrm);
-        sort_taskset(this, ts, &ts_ssrm, i);
-        rts_taskset_add_sorted_pr(&ts_ssrm, t);
-
-        if(rts_taskset_get_size(&ts_ssrm) > (this->prio_max - this->prio_min + 1))
-            continue;
-        else if(!hyperbolic_bound(&ts_ssrm))
-            continue;
-        else if(!workload_analysis(&ts_ssrm))
-            continue;
-        
-        free_cpu = i;
-    }
-    
-    if(free_cpu == -1)
+    if(rts_task_get_util(t) > free_utils[cpu])
         return 0;
     
-    t->cpu = free_cpu;
+    if(!rta_test(this, ts, t, cpu))
+        return 0;
     
     required = 2;
     got = 0;
@@ -303,3 +438,17 @@ float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t
     return (got/ (float)required);
 }
 
+float t_test(struct rts_plugin* this, struct rts_taskset* ts, struct rts_task* t, float* free_utils) {
+    float score;
+    
+    for(int i = 0; i < this->cpunum; i++) {
+        score = t_test_cpu(this, ts, t, i, free_utils);
+        
+        if(score > 0) {
+            t->cpu = i;
+            return score;
+        }
+    }
+    
+    return 0;
+}
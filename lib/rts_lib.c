@@ -1,13 +1,75 @@
+#define _GNU_SOURCE
+
 #include "rts_lib.h"
 #include "../daemon/lib/rts_utils.h"
+#include "../daemon/components/tscclock.h"
+#include "../daemon/components/cpuclock.h"
+#include <sched.h>
+#include <errno.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#ifndef sigev_notify_thread_id
+    #define sigev_notify_thread_id _sigev_un._tid
+#endif
 
-#define MAX_EST_PERIOD 10000
-#define MAX_EST_WCET 5000
+#define MAX_EST_PERIOD 10000     // [ms]
+#define MAX_EST_WCET 5000        // [ms]
 #define MAX_ACT_NUMBER 500
+#define TSC_CALIBRATION 20000000    // [ns]
+#define SCHED_FLAG_DL_OVERRUN 0x04
+
+// ESTIMATOR TABLE: the estimates of every reservation of the process live in
+// one table, created on first use and shared with the daemon on each connection
+
+static struct estable est_table;
+static int est_ready;
+static pthread_mutex_t est_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// called with est_lock held
+static struct estable* rts_est_table() {
+    if(!est_ready && estable_create(&est_table, EST_TABLE_SLOTS, EST_NVALUE) == 0)
+        est_ready = 1;
+    
+    return est_ready ? &est_table : NULL;
+}
+
+static int rts_est_share(struct rts_access* c) {
+    int fd = -1;
+    
+    pthread_mutex_lock(&est_lock);
+    
+    if(rts_est_table() != NULL)
+        fd = est_table.fd;
+    
+    pthread_mutex_unlock(&est_lock);
+    
+    if(fd < 0)
+        return -1;
+    
+    return rts_access_est_setup(c, fd);
+}
+
+static uint64_t rts_est_get(struct rts_params* tp, int index) {
+    return atomic_read(&(tp->estimatedp.value[index]));
+}
+
+static void rts_est_put(struct rts_params* tp, int index, uint64_t value) {
+    atomic_set(&(tp->estimatedp.value[index]), value);
+}
+
+// the thread owning the reservation is the only writer of its estimates
+static void rts_est_write_begin(struct rts_params* tp) {
+    atomic_seq_write_begin(&(tp->estimatedp.value[EST_SEQ]));
+}
+
+static void rts_est_write_end(struct rts_params* tp) {
+    atomic_seq_write_end(&(tp->estimatedp.value[EST_SEQ]));
+}
 
 int rts_daemon_connect(struct rts_access* c) {
     if(rts_access_init(c) < 0)
@@ -15,29 +77,47 @@ int rts_daemon_connect(struct rts_access* c) {
         
     if(rts_access_connect(c) < 0)
         return RTS_ERROR;
-
+    
     c->req.req_type = RTS_CONNECTION;
     c->req.payload.ids.pid = getpid();
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_CONNECTION_ERR)
         return RTS_ERROR;
+    
+    if(rts_est_share(c) < 0)
+        return RTS_ERROR;
+    
+    // optional: capacity queries go through IPC without it
+    rts_snapshot_open(&(c->snap));
+    
+    return RTS_OK;
+}
 
+// Connects and moves the following single requests on a shared-memory ring.
+// On RTS_ERROR after a successful connection the socket transport stays usable.
+int rts_daemon_connect_ring(struct rts_access* c) {
+    if(rts_daemon_connect(c) < 0)
+        return RTS_ERROR;
+    
+    if(rts_access_ring_open(c) < 0)
+        return RTS_ERROR;
+    
     return RTS_OK;
 }
 
 int rts_refresh_sys(struct rts_access* c) {
     c->req.req_type = RTS_REFRESH_SYS;
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_REFRESH_SYS_ERR)
         return RTS_ERROR;
     
@@ -47,12 +127,12 @@ int rts_refresh_sys(struct rts_access* c) {
 int rts_refresh_single(struct rts_access* c, rsv_t rsvid) {
     c->req.req_type = RTS_REFRESH_SINGLE;
     c->req.payload.ids.rsvid = rsvid;
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_REFRESH_SINGLE_ERR)
         return RTS_ERROR;
     
@@ -60,14 +140,19 @@ int rts_refresh_single(struct rts_access* c, rsv_t rsvid) {
 }
 
 float rts_cap_query(struct rts_access* c, enum QUERY_TYPE type) {
+    float value;
+    
+    if(rts_snapshot_cap_query(&(c->snap), type, &value) == 0)
+        return value;
+    
     c->req.req_type = RTS_CAP_QUERY;
     c->req.payload.query_type = type;
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_CAP_QUERY_ERR)
         return RTS_ERROR;
     
@@ -75,18 +160,30 @@ float rts_cap_query(struct rts_access* c, enum QUERY_TYPE type) {
 }
 
 int rts_params_init(struct rts_params *tp) {
+    int slot = -1;
+    
     memset(tp, 0, sizeof(struct rts_params));
-    shatomic_init(&(tp->estimatedp));
+    pthread_mutex_lock(&est_lock);
     
-    if(shatomic_create(&(tp->estimatedp), EST_NVALUE) < 0)
-        return -1;
+    if(rts_est_table() != NULL)
+        slot = estable_alloc(&est_table);
+    
+    pthread_mutex_unlock(&est_lock);
     
-    if(shatomic_attach(&(tp->estimatedp)) < 0)
+    if(slot < 0)
         return -1;
     
-    shatomic_put_value(&(tp->estimatedp), EST_NUM_ACTIVATION, 0);
-    shatomic_put_value(&(tp->estimatedp), EST_PERIOD, MAX_EST_PERIOD);
-    shatomic_put_value(&(tp->estimatedp), EST_WCET, MAX_EST_WCET);
+    tp->estimatedp.slot = slot;
+    tp->estimatedp.value = estable_slot(&est_table, slot);
+    
+    rts_est_write_begin(tp);
+    rts_est_put(tp, EST_NUM_ACTIVATION, 0);
+    rts_est_put(tp, EST_PERIOD, MILLI_TO_NANO((uint64_t)MAX_EST_PERIOD));
+    rts_est_put(tp, EST_WCET, MILLI_TO_NANO((uint64_t)MAX_EST_WCET));
+    rts_est_put(tp, EST_SPLIT_NUM, 0);
+    rts_est_put(tp, EST_SPLIT_FAIL, 0);
+    rts_est_put(tp, EST_GEN, 0);
+    rts_est_write_end(tp);
     
     return 0;
 }
@@ -99,40 +196,64 @@ clockid_t rts_get_clock(struct rts_params* tp) {
     return tp->clk;
 }
 
+// the parameters are kept in ns, the setters without suffix take ms
+
 void rts_set_period(struct rts_params* tp, uint32_t period) {
+    tp->period = MILLI_TO_NANO((uint64_t)period);
+}
+
+void rts_set_period_ns(struct rts_params* tp, uint64_t period) {
     tp->period = period;
 }
 
 int rts_get_period(struct rts_params* tp) {
-    return tp->period;
+    return NANO_TO_MILLI(tp->period);
 }
 
 void rts_set_budget(struct rts_params* tp, uint32_t budget) {
+    tp->budget = MILLI_TO_NANO((uint64_t)budget);
+}
+
+void rts_set_budget_ns(struct rts_params* tp, uint64_t budget) {
     tp->budget = budget;
 }
 
 int rts_get_budget(struct rts_params* tp) {
-    return tp->budget;
+    return NANO_TO_MILLI(tp->budget);
 }
 
 void rts_set_deadline(struct rts_params* tp, uint32_t deadline) {
+    tp->deadline = MILLI_TO_NANO((uint64_t)deadline);
+}
+
+void rts_set_deadline_ns(struct rts_params* tp, uint64_t deadline) {
     tp->deadline = deadline;
 }
 
 int rts_get_deadline(struct rts_params* tp) {
-    return tp->deadline;
+    return NANO_TO_MILLI(tp->deadline);
 }
 
 void rts_set_priority(struct rts_params* tp, uint32_t priority) {
     tp->priority = priority;
 }
 
+// the slot is given back first, so the parameters are reset in place
 void rts_params_cleanup(struct rts_params* tp) {
-    rts_params_init(tp);
+    pthread_mutex_lock(&est_lock);
+    
+    if(tp->estimatedp.value != NULL)
+        estable_free(&est_table, tp->estimatedp.slot);
+    
+    pthread_mutex_unlock(&est_lock);
+    
+    // no slot is taken again: rts_params_init must be called before reuse
+    memset(tp, 0, sizeof(struct rts_params));
+    tp->estimatedp.value = NULL;
 }
 
 uint64_t rts_params_get_est_param(struct rts_params* tp, int FLAG) {
-    return shatomic_get_value(&(tp->estimatedp), FLAG);
+    return rts_est_get(tp, FLAG);
 }
 
 int rts_create_rsv(struct rts_access* c, struct rts_params* tp, rsv_t* id) {
@@ -143,105 +264,418 @@ int rts_create_rsv(struct rts_access* c, struct rts_params* tp, rsv_t* id) {
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_RSV_CREATE_UN || c->rep.rep_type == RTS_RSV_CREATE_ERR)
         return RTS_NOT_GUARANTEED;
+    
+    *id = (rsv_t) c->rep.payload;
+    return RTS_GUARANTEED;
+}
 
+int rts_create_rsv_attach(struct rts_access* c, struct rts_params* tp, pid_t pid, rsv_t* id) {
+    c->req.req_type = RTS_RSV_CREATE_ATTACH;
+    memcpy(&(c->req.payload.create_attach.param), tp, sizeof(struct rts_params));
+    c->req.payload.create_attach.pid = pid;
+    
+    if(rts_access_send(c) < 0)
+        return RTS_ERROR;
+    if(rts_access_recv(c) < 0)
+        return RTS_ERROR;
+    
+    if(c->rep.rep_type != RTS_RSV_CREATE_OK)
+        return RTS_NOT_GUARANTEED;
+    
     *id = (rsv_t) c->rep.payload;
     return RTS_GUARANTEED;
 }
 
+int rts_create_group(struct rts_access* c, struct rts_params* tp, rsv_t* id) {
+    tp->flags |= RTS_RSV_GROUP;
+    return rts_create_rsv(c, tp, id);
+}
+
+// SPLIT RESERVATIONS: each piece runs on its cpu until its budget of thread
+// cpu time is used, then the thread moves itself to the next piece.
+
+struct rts_split {
+    struct rts_params* tp;
+    int piece;
+    int npiece;
+    int has_timer;
+    timer_t timer;
+};
+
+static __thread struct rts_split split;
+static pthread_once_t split_once = PTHREAD_ONCE_INIT;
+
+static void rts_split_arm(uint64_t budget_ns) {
+    struct itimerspec its;
+    
+    memset(&its, 0, sizeof(its));
+    ns_to_timespec(&(its.it_value), budget_ns);
+    timer_settime(split.timer, 0, &its, NULL);
+}
+
+// budget of cpu time of piece k: its runtime less the guard the thread
+// needs to move on before being throttled
+static uint64_t rts_split_budget(int k) {
+    uint64_t runtime = rts_est_get(split.tp, EST_SPLIT_RUNTIME(k));
+    
+    return runtime > RTS_SPLIT_GUARD_NS ? runtime - RTS_SPLIT_GUARD_NS : 0;
+}
+
+// the thread moves to the cpu of piece k, then takes its parameters: if the
+// kernel refuses either, it goes back to the cpu it was on and returns -1
+static int rts_split_move(int k) {
+    cpu_set_t set, prev;
+    uint64_t flags = split.tp->flags & RTS_RSV_NOTIFY_OVERRUN ? SCHED_FLAG_DL_OVERRUN : 0;
+    
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &prev) < 0)
+        return -1;
+    
+    CPU_ZERO(&set);
+    CPU_SET(rts_est_get(split.tp, EST_SPLIT_CPU(k)), &set);
+    
+    if(sched_setaffinity(0, sizeof(cpu_set_t), &set) < 0)
+        return -1;
+    
+    if(set_sched_deadline(0, rts_est_get(split.tp, EST_SPLIT_RUNTIME(k)),
+                          rts_est_get(split.tp, EST_SPLIT_DEADLINE(k)),
+                          rts_est_get(split.tp, EST_SPLIT_PERIOD), flags) < 0) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &prev);
+        return -1;
+    }
+    
+    split.piece = k;
+    
+    // the last piece runs until the job ends
+    if(k < split.npiece - 1)
+        rts_split_arm(rts_split_budget(k));
+    
+    return 0;
+}
+
+// the thread stays where it is and the daemon is told to detach it
+static void rts_split_fail() {
+    rts_split_arm(0);
+    rts_est_put(split.tp, EST_SPLIT_FAIL, 1);
+    split.tp = NULL;
+}
+
+// only async-signal-safe calls below
+static void rts_split_handler(int sig) {
+    int err = errno;
+    
+    if(split.tp != NULL && split.piece < split.npiece - 1 && rts_split_move(split.piece + 1) < 0)
+        rts_split_fail();
+    
+    errno = err;
+}
+
+static void rts_split_install() {
+    struct sigaction sa;
+    
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = rts_split_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&(sa.sa_mask));
+    sigaction(RTS_SPLIT_SIGNAL, &sa, NULL);
+}
+
+static int rts_split_timer_init() {
+    struct sigevent sev;
+    
+    pthread_once(&split_once, rts_split_install);
+    
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = RTS_SPLIT_SIGNAL;
+    sev.sigev_notify_thread_id = syscall(SYS_gettid);
+    
+    if(timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &(split.timer)) < 0)
+        return -1;
+    
+    split.has_timer = 1;
+    return 0;
+}
+
+static void rts_split_begin(struct rts_params* tp) {
+    // published by the daemon after the pieces
+    int npiece = atomic_read_acquire(&(tp->estimatedp.value[EST_SPLIT_NUM]));
+    
+    if(npiece <= 0 || npiece > RTS_SPLIT_MAX || rts_est_get(tp, EST_SPLIT_FAIL)) {
+        if(split.tp == tp)
+            split.tp = NULL;
+        
+        return;
+    }
+    
+    if(!split.has_timer && rts_split_timer_init() < 0)
+        return;
+    
+    // the previous job may have ended on a later piece
+    if(split.tp != tp || split.piece != 0 || split.npiece != npiece) {
+        split.tp = tp;
+        split.npiece = npiece;
+        
+        if(rts_split_move(0) < 0)
+            rts_split_fail();
+    }
+    else
+        rts_split_arm(rts_split_budget(0));
+}
+
+static void rts_split_end(struct rts_params* tp) {
+    if(split.tp != tp)
+        return;
+    
+    rts_split_arm(0);
+    
+    if(split.piece != 0 && rts_split_move(0) < 0)
+        rts_split_fail();
+}
+
+// TIMING: the activations are timed by the kernel clocks, or by the time
+// stamp counter without system calls. The execution times are cpu time in
+// both modes: with the counter they come from a perf counter of the thread,
+// opened on its first activation, or from the kernel clock where it cannot
+// be opened.
+
+static enum RTS_TIMING timing = RTS_TIMING_KERNEL;
+static struct tscclock tsc;
+static __thread struct cpuclock cpuclk;
+static __thread int cpuclk_state;  // 1 open, -1 not available, 0 not tried
+static __thread int exec_src;       // clock of the last activation begun
+
+int rts_set_timing(enum RTS_TIMING mode) {
+    if(mode == RTS_TIMING_TSC && tscclock_init(&tsc, TSC_CALIBRATION) < 0)
+        return RTS_ERROR;
+    
+    timing = mode;
+    return RTS_OK;
+}
+
+static uint64_t rts_time_now(struct rts_params* tp) {
+    return timing == RTS_TIMING_TSC ? tscclock_now(&tsc) : get_time_now_ns(tp->clk);
+}
+
+// cpu time of the thread; returns the clock it was read from, 1 for the
+// perf counter, 0 for the kernel. A counter taken away from the thread is
+// not used again.
+static int rts_time_exec(uint64_t* ns) {
+    if(timing == RTS_TIMING_TSC && cpuclk_state == 0)
+        cpuclk_state = cpuclock_open(&cpuclk) < 0 ? -1 : 1;
+    
+    if(timing == RTS_TIMING_TSC && cpuclk_state == 1) {
+        if(cpuclock_read(&cpuclk, ns) == 0)
+            return 1;
+        
+        cpuclock_close(&cpuclk);
+        cpuclk_state = -1;
+    }
+    
+    *ns = get_thread_time_ns();
+    return 0;
+}
+
+// OVERRUNS: the kernel signals a thread out of budget with SIGXCPU, the
+// handler counts it in the reservation of the last activation of the thread
+
+static __thread struct rts_params* rsv_curr;
+static pthread_once_t overrun_once = PTHREAD_ONCE_INIT;
+
+// only async-signal-safe calls below
+static void rts_overrun_handler(int sig) {
+    if(rsv_curr != NULL)
+        atomic_inc(&(rsv_curr->estimatedp.value[EST_OVERRUN]));
+}
+
+static void rts_overrun_install() {
+    struct sigaction sa;
+    
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = rts_overrun_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&(sa.sa_mask));
+    sigaction(SIGXCPU, &sa, NULL);
+}
+
+void rts_set_overrun_notify(struct rts_params* tp, int on) {
+    if(on) {
+        pthread_once(&overrun_once, rts_overrun_install);
+        tp->flags |= RTS_RSV_NOTIFY_OVERRUN;
+    }
+    else
+        tp->flags &= ~RTS_RSV_NOTIFY_OVERRUN;
+}
+
+void rts_set_group(struct rts_params* tp, rsv_t group) {
+    tp->group = group;
+}
+
+// the daemon re-reads the estimates of a reservation on refresh only
+// when their generation moved; called inside a write section
+static void rts_est_changed(struct rts_params* tp) {
+    rts_est_put(tp, EST_GEN, rts_est_get(tp, EST_GEN) + 1);
+}
+
 void rts_rsv_begin(struct rts_params* tp) {
     uint32_t t_act_num;
-    uint32_t t_period;
-    uint32_t t_period_curr;
-    uint32_t t_period_prec;
-    uint32_t t_abs_act_prec;
-    uint32_t t_abs_act_curr;
-    uint32_t t_perthread_act;
+    uint64_t t_period;
+    uint64_t t_period_curr;
+    uint64_t t_period_prec;
+    uint64_t t_abs_act_prec;
+    uint64_t t_abs_act_curr;
+    uint64_t t_perthread_act;
     
-    t_act_num = shatomic_get_value(&(tp->estimatedp), EST_NUM_ACTIVATION);
+    t_act_num = rts_est_get(tp, EST_NUM_ACTIVATION);
     
-    t_abs_act_prec = shatomic_get_value(&(tp->estimatedp), EST_ABS_ACTIVATION);
-    t_abs_act_curr = get_time_now_ms(tp->clk);
+    t_abs_act_prec = rts_est_get(tp, EST_ABS_ACTIVATION);
+    t_abs_act_curr = rts_time_now(tp);
+    exec_src = rts_time_exec(&t_perthread_act);
+    rsv_curr = tp;
+    
+    // the daemon sees the period move along with the activations
+    rts_est_write_begin(tp);
     
     if(t_act_num > 0) {
-        t_period_prec = shatomic_get_value(&(tp->estimatedp), EST_PERIOD);
+        t_period_prec = rts_est_get(tp, EST_PERIOD);
         t_period = t_abs_act_curr - t_abs_act_prec;
         t_period_curr = REACTIVITY * t_period + (1 - REACTIVITY) * t_period_prec;
-        shatomic_put_value(&(tp->estimatedp), EST_PERIOD, t_period_curr);
+        rts_est_put(tp, EST_PERIOD, t_period_curr);
+        
+        if(t_period_curr != t_period_prec)
+            rts_est_changed(tp);
     }
     
-    t_perthread_act = get_thread_time_ms(tp->clk);
+    rts_est_put(tp, EST_PERTHREADCLK, t_perthread_act);
+    rts_est_put(tp, EST_NUM_ACTIVATION, ++t_act_num);
+    rts_est_put(tp, EST_ABS_ACTIVATION, t_abs_act_curr);
+    rts_est_write_end(tp);
     
-    shatomic_put_value(&(tp->estimatedp), EST_PERTHREADCLK, t_perthread_act);
-    shatomic_put_value(&(tp->estimatedp), EST_NUM_ACTIVATION, ++t_act_num);
-    shatomic_put_value(&(tp->estimatedp), EST_ABS_ACTIVATION, t_abs_act_curr);
+    rts_split_begin(tp);
+}
+
+// adds an execution time to the histogram; returns 1 if the daemon has to
+// re-read the estimates. Called inside a write section.
+static int rts_est_sample(struct rts_params* tp, uint64_t value) {
+    int b = loghist_bucket(value);
+    uint64_t num = rts_est_get(tp, EST_HIST_NUM) + 1;
+    uint64_t top = rts_est_get(tp, EST_HIST_TOP);
+    uint64_t count;
+    int changed;
+    
+    changed = (uint64_t)b >= top || num % EST_HIST_STEP == 0;
+    rts_est_put(tp, EST_HIST(b), rts_est_get(tp, EST_HIST(b)) + 1);
+    
+    if((uint64_t)b >= top)
+        top = b + 1;
+    
+    if(num >= EST_HIST_WINDOW) {
+        num = 0;
+        
+        for(uint64_t i = 0; i < top; i++) {
+            count = rts_est_get(tp, EST_HIST(i)) / 2;
+            rts_est_put(tp, EST_HIST(i), count);
+            num += count;
+        }
+        
+        while(top > 0 && rts_est_get(tp, EST_HIST(top - 1)) == 0)
+            top--;
+        
+        changed = 1;
+    }
+    
+    rts_est_put(tp, EST_HIST_NUM, num);
+    rts_est_put(tp, EST_HIST_TOP, top);
+    return changed;
 }
 
 void rts_rsv_end(struct rts_params* tp) {
     uint32_t t_act_num;
-    uint32_t t_wcet_curr;
-    uint32_t t_wcet_prec;
-    uint32_t t_perthread_prec;
-    uint32_t t_perthread_curr;
+    uint64_t t_wcet_curr;
+    uint64_t t_wcet_prec;
+    uint64_t t_perthread_prec;
+    uint64_t t_perthread_curr;
+    uint64_t t_deadline;
+    uint64_t t_now;
+    int src;
+    
+    t_act_num = rts_est_get(tp, EST_NUM_ACTIVATION);
+    t_wcet_prec = rts_est_get(tp, EST_WCET);
+    t_perthread_prec = rts_est_get(tp, EST_PERTHREADCLK);  
+    src = rts_time_exec(&t_perthread_curr);
     
-    t_act_num = shatomic_get_value(&(tp->estimatedp), EST_NUM_ACTIVATION);
-    t_wcet_prec = shatomic_get_value(&(tp->estimatedp), EST_WCET);
-    t_perthread_prec = shatomic_get_value(&(tp->estimatedp), EST_PERTHREADCLK);  
-    t_perthread_curr = get_thread_time_ms(tp->clk);
+    // deadline misses are counted when the reservation has a deadline
+    t_deadline = tp->deadline != 0 ? tp->deadline : tp->period;
+    t_now = rts_time_now(tp);
     
-    t_wcet_curr = t_perthread_curr - t_perthread_prec;
+    rts_est_write_begin(tp);
     
-    if(t_act_num > 1)
-        t_wcet_curr = ((t_wcet_prec > t_wcet_curr) ? t_wcet_prec : t_wcet_curr);
+    if(t_deadline != 0 && t_now - rts_est_get(tp, EST_ABS_ACTIVATION) > t_deadline)
+        rts_est_put(tp, EST_MISS, rts_est_get(tp, EST_MISS) + 1);
+    
+    // the activation began on a counter lost meanwhile: no sample
+    if(src == exec_src) {
+        t_wcet_curr = t_perthread_curr - t_perthread_prec;
+        
+        if(t_act_num > 1)
+            t_wcet_curr = ((t_wcet_prec > t_wcet_curr) ? t_wcet_prec : t_wcet_curr);
         
-    shatomic_put_value(&(tp->estimatedp), EST_WCET, t_wcet_curr); 
+        rts_est_put(tp, EST_WCET, t_wcet_curr); 
+        
+        if(rts_est_sample(tp, t_perthread_curr - t_perthread_prec))
+            rts_est_changed(tp);
+    }
+    
+    rts_est_write_end(tp);
+    
+    rts_split_end(tp);
 }
 
 int rts_rsv_attach_thread(struct rts_access* c, rsv_t id, pid_t pid) {
     c->req.req_type = RTS_RSV_ATTACH;
     c->req.payload.ids.rsvid = id;
     c->req.payload.ids.pid = pid;
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_RSV_ATTACH_ERR)
         return RTS_ERROR;
-
+    
     return RTS_OK;
 }
 
 int rts_rsv_detach_thread(struct rts_access* c, rsv_t id) {
     c->req.req_type = RTS_RSV_DETACH;
     c->req.payload.ids.rsvid = id;
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_RSV_DETACH_ERR)
         return RTS_ERROR;
-
+    
     return RTS_OK;
 }
 
 int rts_rsv_get_remaining_budget(struct rts_access* c, rsv_t id, float* budget) {
     c->req.req_type = RTS_RSV_QUERY;
     c->req.payload.ids.rsvid = id;    
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_RSV_QUERY_ERR)
         return RTS_ERROR;
-
+    
     *budget = c->rep.payload;
     return RTS_OK;
 }
@@ -249,38 +683,153 @@ int rts_rsv_get_remaining_budget(struct rts_access* c, rsv_t id, float* budget)
 int rts_rsv_destroy(struct rts_access* c, rsv_t id) {
     c->req.req_type = RTS_RSV_DESTROY;
     c->req.payload.ids.rsvid = id;
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
     if(c->rep.rep_type == RTS_RSV_DESTROY_ERR)
         return RTS_ERROR;
-
+    
     return RTS_OK;
 }
 
 int rts_daemon_deconnect(struct rts_access* c) {
     c->req.req_type = RTS_DECONNECTION;
     c->req.payload.ids.pid = getpid();
-
+    
     if(rts_access_send(c) < 0)
         return RTS_ERROR;
     if(rts_access_recv(c) < 0)
         return RTS_ERROR;
-
+    
+    rts_access_ring_close(c);
+    rts_snapshot_close(&(c->snap));
+    
     if(c->rep.rep_type == RTS_DECONNECTION_ERR)
         return RTS_ERROR;
+    
+    return RTS_OK;
+}
+
+// BATCH
+
+static struct rts_request* rts_batch_next(struct rts_batch* b) {
+    if(b->nreq >= CHANNEL_BATCH_MAX)
+        return NULL;
+    
+    return &(b->req[++b->nreq]);
+}
+
+void rts_batch_init(struct rts_batch* b) {
+    b->nreq = 0;
+}
+
+int rts_batch_create_rsv(struct rts_batch* b, struct rts_params* tp) {
+    struct rts_request* req = rts_batch_next(b);
+    
+    if(req == NULL)
+        return RTS_ERROR;
+    
+    req->req_type = RTS_RSV_CREATE;
+    memcpy(&(req->payload.param), tp, sizeof(struct rts_params));
+    
+    return b->nreq - 1;
+}
 
+int rts_batch_create_rsv_attach(struct rts_batch* b, struct rts_params* tp, pid_t pid) {
+    struct rts_request* req = rts_batch_next(b);
+    
+    if(req == NULL)
+        return RTS_ERROR;
+    
+    req->req_type = RTS_RSV_CREATE_ATTACH;
+    memcpy(&(req->payload.create_attach.param), tp, sizeof(struct rts_params));
+    req->payload.create_attach.pid = pid;
+    
+    return b->nreq - 1;
+}
+
+int rts_batch_rsv_attach_thread(struct rts_batch* b, rsv_t id, pid_t pid) {
+    struct rts_request* req = rts_batch_next(b);
+    
+    if(req == NULL)
+        return RTS_ERROR;
+    
+    req->req_type = RTS_RSV_ATTACH;
+    req->payload.ids.rsvid = id;
+    req->payload.ids.pid = pid;
+    
+    return b->nreq - 1;
+}
+
+int rts_batch_rsv_detach_thread(struct rts_batch* b, rsv_t id) {
+    struct rts_request* req = rts_batch_next(b);
+    
+    if(req == NULL)
+        return RTS_ERROR;
+    
+    req->req_type = RTS_RSV_DETACH;
+    req->payload.ids.rsvid = id;
+    
+    return b->nreq - 1;
+}
+
+int rts_batch_rsv_destroy(struct rts_batch* b, rsv_t id) {
+    struct rts_request* req = rts_batch_next(b);
+    
+    if(req == NULL)
+        return RTS_ERROR;
+    
+    req->req_type = RTS_RSV_DESTROY;
+    req->payload.ids.rsvid = id;
+    
+    return b->nreq - 1;
+}
+
+int rts_batch_submit(struct rts_access* c, struct rts_batch* b) {
+    if(b->nreq == 0)
+        return RTS_OK;
+    
+    if(rts_access_send_batch(c, b) < 0)
+        return RTS_ERROR;
+    if(rts_access_recv_batch(c, b) < (int)(b->nreq * sizeof(struct rts_reply)))
+        return RTS_ERROR;
+    
     return RTS_OK;
 }
 
+int rts_batch_get_result(struct rts_batch* b, int i) {
+    if(i < 0 || i >= b->nreq)
+        return RTS_ERROR;
+    
+    switch(b->rep[i].rep_type) {
+        case RTS_REQUEST_ERR:
+        case RTS_RSV_CREATE_UN:
+        case RTS_RSV_CREATE_ERR:
+        case RTS_RSV_ATTACH_ERR:
+        case RTS_RSV_DETACH_ERR:
+        case RTS_RSV_DESTROY_ERR:
+            return RTS_ERROR;
+        default:
+            return RTS_OK;
+    }
+}
+
+int rts_batch_get_rsv(struct rts_batch* b, int i, rsv_t* id) {
+    if(rts_batch_get_result(b, i) != RTS_OK)
+        return RTS_NOT_GUARANTEED;
+    
+    *id = (rsv_t) b->rep[i].payload;
+    return RTS_GUARANTEED;
+}
+
 // TASK TIME MANAG
 
 void rts_thread_init(struct rts_thread* t, struct rts_params* p) {
-    rts_thread_calc_exec(t, p->budget, p->period, p->deadline);
-    rts_thread_calc_period(t, p->budget, p->period, p->deadline);
+    rts_thread_calc_exec(t, rts_get_budget(p), rts_get_period(p), rts_get_deadline(p));
+    rts_thread_calc_period(t, rts_get_budget(p), rts_get_period(p), rts_get_deadline(p));
     get_time_now2(p->clk, &(t->t_activation_time));
 }
 
@@ -340,9 +889,9 @@ void rts_thread_print_info(struct rts_thread* t, struct rts_params* p, int tid)
             t->t_period, 
             t->t_activation_num_curr,
             t->t_activation_num_tot,
-            rts_params_get_est_param(p, EST_WCET),
-            rts_params_get_est_param(p, EST_PERIOD),
-            rts_params_get_est_param(p, EST_PERTHREADCLK));
+            NANO_TO_MILLI(rts_params_get_est_param(p, EST_WCET)),
+            NANO_TO_MILLI(rts_params_get_est_param(p, EST_PERIOD)),
+            NANO_TO_MILLI(rts_params_get_est_param(p, EST_PERTHREADCLK)));
 }
 
 float rts_thread_calc_budget(struct rts_thread* t, struct rts_params* p) {
@@ -352,12 +901,12 @@ float rts_thread_calc_budget(struct rts_thread* t, struct rts_params* p) {
     if(t->t_period != 0)
         period = t->t_period;
     else
-        period = rts_params_get_est_param(p, EST_PERIOD);
+        period = rts_params_get_est_param(p, EST_PERIOD) / (float)EXP6;
     
     if(t->t_wcet != 0)
         wcet = t->t_wcet;
     else
-        wcet = rts_params_get_est_param(p, EST_WCET);
+        wcet = rts_params_get_est_param(p, EST_WCET) / (float)EXP6;
     
     return wcet / period;
 }
@@ -373,15 +922,15 @@ float rts_thread_calc_rem_budget(struct rts_thread* t, struct rts_params* p) {
     if(t->t_wcet != 0)
         wcet = t->t_wcet;
     else
-        wcet = rts_params_get_est_param(p, EST_WCET);
+        wcet = NANO_TO_MILLI(rts_params_get_est_param(p, EST_WCET));
     
     if(t->t_period != 0)
         period = t->t_period;
     else
-        period = rts_params_get_est_param(p, EST_PERIOD);
+        period = NANO_TO_MILLI(rts_params_get_est_param(p, EST_PERIOD));
     
     cputimenow = get_thread_time_ms();
-    cputimeact = rts_params_get_est_param(p, EST_PERTHREADCLK);        
+    cputimeact = NANO_TO_MILLI(rts_params_get_est_param(p, EST_PERTHREADCLK));        
             
     budget_total = rts_thread_calc_budget(t, p);
     budget_used = (wcet - (cputimenow - cputimeact)) / period;
@@ -2,6 +2,7 @@
 #define RTS_LIB_H
 
 #include "../daemon/lib/rts_channel.h"
+#include <signal.h>
 #include <time.h>
 
 #define REACTIVITY 0.5
@@ -9,6 +10,19 @@
 #define DEADLINE_TO_PERIOD(dl) dl * 2
 #define WCET_TO_PERIOD(wcet) wcet * 3
 
+// raised when a split reservation used up the budget of its current piece
+#define RTS_SPLIT_SIGNAL (SIGRTMIN + 1)
+
+// time source of rts_rsv_begin and rts_rsv_end. TSC reads the time stamp
+// counter, calibrated against CLOCK_MONOTONIC, without system calls, and
+// takes the execution time of an activation from a perf counter of the
+// thread (see cpuclock.h); where the thread cannot open one, from the
+// kernel thread clock. Preemptions are left out in both modes.
+enum RTS_TIMING {
+    RTS_TIMING_KERNEL,
+    RTS_TIMING_TSC
+};
+
 struct rts_thread {
     uint32_t t_num;
     uint32_t t_period;
@@ -20,32 +34,64 @@ struct rts_thread {
 
 int rts_daemon_connect(struct rts_access* c);
 
+int rts_daemon_connect_ring(struct rts_access* c);
+
 int rts_refresh_sys(struct rts_access* c);
 
 int rts_refresh_single(struct rts_access* c, rsv_t rsvid);
 
 float rts_cap_query(struct rts_access* c, enum QUERY_TYPE type);
 
+// to be called before the first activation; RTS_ERROR if the mode is not
+// available (e.g. the counter is not invariant), the kernel clocks are kept
+int rts_set_timing(enum RTS_TIMING mode);
+
 int rts_params_init(struct rts_params *tp);
 
 void rts_set_clock(struct rts_params* tp, clockid_t clk);
 
 clockid_t rts_get_clock(struct rts_params* tp);
 
+// period, budget and deadline in ms
 void rts_set_period(struct rts_params* tp, uint32_t period);
 
 void rts_set_budget(struct rts_params* tp, uint32_t budget);
 
 void rts_set_deadline(struct rts_params* tp, uint32_t deadline);
 
+// period, budget and deadline in ns
+void rts_set_period_ns(struct rts_params* tp, uint64_t period);
+
+void rts_set_budget_ns(struct rts_params* tp, uint64_t budget);
+
+void rts_set_deadline_ns(struct rts_params* tp, uint64_t deadline);
+
 void rts_set_priority(struct rts_params* tp, uint32_t priority);
 
+// has the kernel signal the threads of the reservation that run out of its
+// budget; the overruns are counted and, when repeated, the daemon grows the
+// budget. Installs a SIGXCPU handler in the process: the threads attached
+// to the reservation must belong to it.
+void rts_set_overrun_notify(struct rts_params* tp, int on);
+
+// admits the reservation inside a group of the same client, by a test
+// over the group alone; 0, the default, admits it on the node
+void rts_set_group(struct rts_params* tp, rsv_t group);
+
+// gives the estimator slot back, tp needs rts_params_init to be used again
 void rts_params_cleanup(struct rts_params* tp);
 
 uint64_t rts_params_get_est_param(struct rts_params* tp, int FLAG);
 
 int rts_create_rsv(struct rts_access* c, struct rts_params* tp, rsv_t* id);
 
+int rts_create_rsv_attach(struct rts_access* c, struct rts_params* tp, pid_t pid, rsv_t* id);
+
+// reserves budget every period on a cpu for the reservations created
+// inside the group later on (see rts_set_group); no thread is attached to
+// the group itself
+int rts_create_group(struct rts_access* c, struct rts_params* tp, rsv_t* id);
+
 int rts_rsv_attach_thread(struct rts_access* c, rsv_t id, pid_t pid);
 
 int rts_rsv_detach_thread(struct rts_access* c, rsv_t id);
@@ -56,6 +102,26 @@ int rts_rsv_destroy(struct rts_access* c, rsv_t id);
 
 int rts_daemon_deconnect(struct rts_access* c);
 
+// BATCH
+
+void rts_batch_init(struct rts_batch* b);
+
+int rts_batch_create_rsv(struct rts_batch* b, struct rts_params* tp);
+
+int rts_batch_create_rsv_attach(struct rts_batch* b, struct rts_params* tp, pid_t pid);
+
+int rts_batch_rsv_attach_thread(struct rts_batch* b, rsv_t id, pid_t pid);
+
+int rts_batch_rsv_detach_thread(struct rts_batch* b, rsv_t id);
+
+int rts_batch_rsv_destroy(struct rts_batch* b, rsv_t id);
+
+int rts_batch_submit(struct rts_access* c, struct rts_batch* b);
+
+int rts_batch_get_result(struct rts_batch* b, int i);
+
+int rts_batch_get_rsv(struct rts_batch* b, int i, rsv_t* id);
+
 void rts_rsv_begin(struct rts_params* tp);
 
 void rts_rsv_end(struct rts_params* tp);
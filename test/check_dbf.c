@@ -0,0 +1,55 @@
+#include "../daemon/plugin/sched_EDF.c"
+#include "checkutils.h"
+
+#define MS 1000000.0
+
+#define NSET(set) ((int)(sizeof(set) / sizeof(set[0])))
+
+// implicit deadlines are decided by the utilization alone
+static void check_implicit() {
+    struct dbf_task half[] = {{2 * MS, 10 * MS, 10 * MS}, {5 * MS, 10 * MS, 10 * MS}};
+    struct dbf_task full[] = {{5 * MS, 10 * MS, 10 * MS}, {2 * MS, 4 * MS, 4 * MS}};
+    struct dbf_task over[] = {{6 * MS, 10 * MS, 10 * MS}, {5 * MS, 10 * MS, 10 * MS}};
+    
+    CHECK(dbf_test(half, NSET(half)) == 1);
+    CHECK(dbf_test(full, NSET(full)) == 1);
+    CHECK(dbf_test(over, NSET(over)) == 0);
+}
+
+// constrained deadlines, (C, D, T) in ms
+static void check_constrained() {
+    // dbf(4) = 2, dbf(6) = 2 + 3 = 5, busy period bound 4.8
+    struct dbf_task pass[] = {{2 * MS, 4 * MS, 10 * MS}, {3 * MS, 6 * MS, 10 * MS}};
+    // u = 0.5 but dbf(4) = 2 + 3 = 5 > 4
+    struct dbf_task fail[] = {{2 * MS, 3 * MS, 10 * MS}, {3 * MS, 4 * MS, 10 * MS}};
+    // dbf(3) = 2, dbf(7) = 2 * 2 + 3 = 7, busy period bound 7
+    struct dbf_task tight[] = {{2 * MS, 3 * MS, 4 * MS}, {3 * MS, 7 * MS, 8 * MS}};
+    // the second job of the first task: dbf(7) = 2 * 2 + 3.5 = 7.5 > 7
+    struct dbf_task late[] = {{2 * MS, 3 * MS, 4 * MS}, {3.5 * MS, 7 * MS, 8 * MS}};
+    // a full cpu bounds no busy period
+    struct dbf_task full[] = {{5 * MS, 8 * MS, 10 * MS}, {5 * MS, 10 * MS, 10 * MS}};
+    
+    CHECK(dbf_test(pass, NSET(pass)) == 1);
+    CHECK(dbf_test(fail, NSET(fail)) == 0);
+    CHECK(dbf_test(tight, NSET(tight)) == 1);
+    CHECK(dbf_test(late, NSET(late)) == 0);
+    CHECK(dbf_test(full, NSET(full)) == 0);
+}
+
+// a job that cannot fit its own deadline, or a task with no period
+static void check_invalid() {
+    struct dbf_task wide[] = {{3 * MS, 2 * MS, 10 * MS}};
+    struct dbf_task noperiod[] = {{1 * MS, 10 * MS, 0}};
+    
+    CHECK(dbf_test(wide, NSET(wide)) == 0);
+    CHECK(dbf_test(noperiod, NSET(noperiod)) == 0);
+    CHECK(dbf_test(NULL, 0) == 1);
+}
+
+int main() {
+    check_implicit();
+    check_constrained();
+    check_invalid();
+    
+    return CHECK_DONE("dbf");
+}
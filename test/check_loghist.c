@@ -0,0 +1,65 @@
+#include "checkutils.h"
+#include "../daemon/components/loghist.h"
+#include <stdint.h>
+
+// below 2^10 ns all in bucket 0, then 8 buckets per power of two:
+// [1024, 2048) is split in buckets 1..8 of 128 ns each
+static void check_bucket() {
+    CHECK(loghist_bucket(0) == 0);
+    CHECK(loghist_bucket(1023) == 0);
+    CHECK(loghist_bucket(1024) == 1);
+    CHECK(loghist_bucket(1151) == 1);
+    CHECK(loghist_bucket(1152) == 2);
+    CHECK(loghist_bucket(2047) == 8);
+    CHECK(loghist_bucket(2048) == 9);
+    
+    // 1 ms: 2^19 <= 10^6 < 2^20, top of its group
+    CHECK(loghist_bucket(1000000) == 80);
+    
+    // from 2^34 ns on, the last bucket
+    CHECK(loghist_bucket(((uint64_t)1 << 34) - 1) == LOGHIST_NBUCKET - 1);
+    CHECK(loghist_bucket((uint64_t)1 << 34) == LOGHIST_NBUCKET - 1);
+    CHECK(loghist_bucket(UINT64_MAX) == LOGHIST_NBUCKET - 1);
+}
+
+// the upper bound of each bucket is the lower bound of the next one
+static void check_upper() {
+    CHECK(loghist_upper(0) == 1024);
+    CHECK(loghist_upper(1) == 1152);
+    CHECK(loghist_upper(8) == 2048);
+    CHECK(loghist_upper(80) == 1048576);
+    
+    for(int b = 0; b < LOGHIST_NBUCKET - 2; b++) {
+        CHECK(loghist_bucket(loghist_upper(b) - 1) == b);
+        CHECK(loghist_bucket(loghist_upper(b)) == b + 1);
+    }
+}
+
+// 10 samples: 2 below 1024 ns, 5 in [1152, 1280), 3 in [1920, 2048)
+static void check_quantile() {
+    uint64_t count[LOGHIST_NBUCKET] = {0};
+    
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 0.5) == 0);
+    
+    count[0] = 2;
+    count[2] = 5;
+    count[8] = 3;
+    
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 0) == 1024);
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 0.2) == 1024);
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 0.25) == 1280);
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 0.5) == 1280);
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 0.75) == 2048);
+    CHECK(loghist_quantile(count, LOGHIST_NBUCKET, 1) == 2048);
+    
+    // the buckets above nbucket are not counted
+    CHECK(loghist_quantile(count, 3, 1) == 1280);
+}
+
+int main() {
+    check_bucket();
+    check_upper();
+    check_quantile();
+    
+    return CHECK_DONE("loghist");
+}
@@ -0,0 +1,64 @@
+#include "checkutils.h"
+#include "../daemon/components/prm.h"
+#include <stdint.h>
+
+#define NSET(set) ((int)(sizeof(set) / sizeof(set[0])))
+
+// resource (10, 4): no supply for the first 2 * (10 - 4) = 12, then 4
+// more in each window [10 k + 2, 10 k + 6] and none outside of them
+static void check_sbf() {
+    CHECK(prm_sbf(10, 4, 0) == 0);
+    CHECK(prm_sbf(10, 4, 6) == 0);
+    CHECK(prm_sbf(10, 4, 7) == 0);
+    CHECK(prm_sbf(10, 4, 12) == 0);
+    CHECK(prm_sbf(10, 4, 13) == 1);
+    CHECK(prm_sbf(10, 4, 16) == 4);
+    CHECK(prm_sbf(10, 4, 17) == 4);
+    CHECK(prm_sbf(10, 4, 22) == 4);
+    CHECK(prm_sbf(10, 4, 26) == 8);
+    CHECK(prm_sbf(10, 4, 30) == 8);
+    CHECK(prm_sbf(10, 4, 36) == 12);
+    
+    // one period later, one budget more
+    for(uint64_t t = 7; t < 100; t++)
+        CHECK(prm_sbf(10, 4, t + 10) == prm_sbf(10, 4, t) + 4);
+    
+    // a dedicated cpu supplies all the interval, an empty one nothing
+    CHECK(prm_sbf(10, 10, 5) == 5 && prm_sbf(10, 10, 15) == 15);
+    CHECK(prm_sbf(10, 0, 100) == 0);
+}
+
+// tasks (wcet, deadline, period) on the resource (10, 4)
+static void check_edf() {
+    // dbf(16) = 2 <= sbf(16) = 4, busy period bound 17.3
+    struct prm_task light[] = {{2, 16, 20}};
+    // dbf(16) = 4 <= 4, the next deadline 36 is past the bound 28
+    struct prm_task tight[] = {{4, 16, 20}};
+    // u = 0.25 < 0.4 but dbf(16) = 5 > 4
+    struct prm_task late[] = {{5, 16, 20}};
+    // a deadline within the blackout: dbf(12) = 1 > 0
+    struct prm_task blackout[] = {{1, 12, 20}, {3, 16, 40}};
+    // one past the blackout: dbf(13) = 1 <= 1, dbf(16) = 4 <= 4
+    struct prm_task after[] = {{1, 13, 20}, {3, 16, 40}};
+    // the whole bandwidth of the resource
+    struct prm_task full[] = {{4, 10, 10}};
+    
+    CHECK(prm_edf_test(light, NSET(light), 10, 4) == 1);
+    CHECK(prm_edf_test(tight, NSET(tight), 10, 4) == 1);
+    CHECK(prm_edf_test(late, NSET(late), 10, 4) == 0);
+    CHECK(prm_edf_test(blackout, NSET(blackout), 10, 4) == 0);
+    CHECK(prm_edf_test(after, NSET(after), 10, 4) == 1);
+    CHECK(prm_edf_test(full, NSET(full), 10, 4) == 0);
+    
+    // no task fits an invalid resource, no task always fits
+    CHECK(prm_edf_test(light, NSET(light), 10, 11) == 0);
+    CHECK(prm_edf_test(light, NSET(light), 10, 0) == 0);
+    CHECK(prm_edf_test(NULL, 0, 10, 0) == 1);
+}
+
+int main() {
+    check_sbf();
+    check_edf();
+    
+    return CHECK_DONE("prm");
+}
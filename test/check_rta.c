@@ -0,0 +1,96 @@
+#include "../daemon/plugin/sched_SSRM.c"
+#include "checkutils.h"
+
+#define NTASK 6
+
+static struct rts_task task[NTASK];
+
+static struct rts_task* mktask(int k, uint64_t C, uint64_t T) {
+    struct rts_task* t = &(task[k]);
+    
+    rts_task_setup(t, k + 1, CLOCK_MONOTONIC);
+    rts_task_set_wcet(t, C);
+    rts_task_set_period(t, T);
+    return t;
+}
+
+// t1 (C 1, T 4) and t3 (C 3, T 13) on the cpu, t2 (C 2, T 6) admitted in
+// between. By hand, with rate monotonic priorities and D = T:
+//   R1 = 1
+//   R2 = 2 + ceil(R2/4) = 3
+//   R3 = 3 + ceil(R3/4) = 4, then with t2
+//   R3 = 3 + ceil(R3/4) + 2 ceil(R3/6): 6, 7, 9, 10, 10
+static void check_admission(struct rts_plugin* plg, struct rts_taskset* ts) {
+    struct rta_cpu* rc;
+    
+    rts_taskset_add_top(ts, mktask(0, 1, 4));
+    rts_taskset_add_top(ts, mktask(2, 3, 13));
+    
+    CHECK(rta_test(plg, ts, mktask(1, 2, 6), 0) == 1);
+    
+    rc = rta_get(plg, 0);
+    CHECK(rc->valid && rc->n == 2);
+    CHECK(rc->e[0].R == 1 && rc->e[1].R == 4);
+    CHECK(rc->pend_id == 2 && rc->pend_pos == 1);
+    CHECK(rc->pend_R[0] == 3 && rc->pend_R[1] == 10);
+    
+    rts_taskset_add_top(ts, &(task[1]));
+    rta_commit(plg, &(task[1]));
+    
+    CHECK(rc->n == 3 && rc->pend_id == -1);
+    CHECK(rc->e[0].id == 1 && rc->e[1].id == 2 && rc->e[2].id == 3);
+    CHECK(rc->e[0].R == 1 && rc->e[1].R == 3 && rc->e[2].R == 10);
+}
+
+// t4 (C 3, T 12) goes above t3:
+//   R4 = 3 + ceil(R4/4) + 2 ceil(R4/6): 6, 7, 9, 10, 10 <= 12
+//   R3 = 3 + ... + 3 ceil(R3/12) from 10 + 3 = 13: 16 > 13
+// the cache is left as it was
+static void check_rejection(struct rts_plugin* plg, struct rts_taskset* ts) {
+    struct rta_cpu* rc = rta_get(plg, 0);
+    
+    CHECK(rta_test(plg, ts, mktask(3, 3, 12), 0) == 0);
+    CHECK(rc->valid && rc->n == 3 && rc->pend_id == -1);
+    CHECK(rc->e[1].R == 3 && rc->e[2].R == 10);
+}
+
+// t5 (C 0, T 5) delays nobody and keeps the response times below it
+static void check_no_execution(struct rts_plugin* plg, struct rts_taskset* ts) {
+    struct rta_cpu* rc = rta_get(plg, 0);
+    
+    CHECK(rta_test(plg, ts, mktask(4, 0, 5), 0) == 1);
+    CHECK(rc->pend_pos == 1 && rc->pend_R[0] == 0);
+    CHECK(rc->pend_R[1] == 3 && rc->pend_R[2] == 10);
+    
+    rts_taskset_add_top(ts, &(task[4]));
+    rta_commit(plg, &(task[4]));
+    
+    CHECK(rc->n == 4 && rc->e[1].id == 5);
+    CHECK(rc->e[2].R == 3 && rc->e[3].R == 10);
+    
+    // a rebuild from the taskset finds the same response times
+    rta_invalidate(plg, 0);
+    CHECK(rta_test(plg, ts, mktask(5, 1, 100), 0) == 1);
+    CHECK(rc->n == 4 && rc->e[0].R == 1 && rc->e[1].R == 0);
+    CHECK(rc->e[2].R == 3 && rc->e[3].R == 10);
+}
+
+int main() {
+    struct rts_plugin plg;
+    struct rts_taskset ts;
+    
+    memset(&plg, 0, sizeof(plg));
+    plg.cpunum = 1;
+    plg.prio_min = 50;
+    plg.prio_max = 99;
+    rts_taskset_init(&ts);
+    
+    check_admission(&plg, &ts);
+    check_rejection(&plg, &ts);
+    check_no_execution(&plg, &ts);
+    
+    plugin_destroy(&plg);
+    rts_taskset_destroy(&ts);
+    
+    return CHECK_DONE("rta");
+}
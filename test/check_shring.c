@@ -0,0 +1,77 @@
+#include "checkutils.h"
+#include "../daemon/components/shring.h"
+#include <stdint.h>
+
+#define RING_NELEM 4
+
+// a ring of 4 slots: fills up, wraps around its slots and its counters
+static void check_wraparound() {
+    struct shring r;
+    uint32_t v;
+    
+    CHECK(shring_create(&r, 3, sizeof(uint32_t)) == 0);
+    CHECK(r.nelem == RING_NELEM);
+    CHECK(shring_is_empty(&r));
+    CHECK(shring_pop(&r, &v) < 0);
+    
+    for(v = 0; v < RING_NELEM; v++)
+        CHECK(shring_push(&r, &v) == 0);
+    
+    CHECK(shring_push(&r, &v) < 0);
+    
+    // first in, first out across ten turns of the slots
+    for(uint32_t i = 0; i < 10 * RING_NELEM; i++) {
+        CHECK(shring_pop(&r, &v) == 0 && v == i);
+        v = i + RING_NELEM;
+        CHECK(shring_push(&r, &v) == 0);
+    }
+    
+    for(uint32_t i = 10 * RING_NELEM; i < 11 * RING_NELEM; i++)
+        CHECK(shring_pop(&r, &v) == 0 && v == i);
+    
+    CHECK(shring_is_empty(&r));
+    
+    // counters about to overflow: full and empty still hold across 0
+    atomic_set(&(r.hdr->head), UINT64_MAX - 1);
+    atomic_set(&(r.hdr->tail), UINT64_MAX - 1);
+    
+    for(v = 100; v < 100 + RING_NELEM; v++)
+        CHECK(shring_push(&r, &v) == 0);
+    
+    CHECK(atomic_read(&(r.hdr->head)) == RING_NELEM - 2);
+    CHECK(shring_push(&r, &v) < 0);
+    
+    for(uint32_t i = 100; i < 100 + RING_NELEM; i++)
+        CHECK(shring_pop(&r, &v) == 0 && v == i);
+    
+    CHECK(shring_is_empty(&r));
+    CHECK(shring_pop(&r, &v) < 0);
+    
+    shring_close(&r);
+}
+
+// a producer that ran more than a ring ahead: the overwritten slots are
+// skipped, the last RING_NELEM pushed are read
+static void check_overrun() {
+    struct shring r;
+    uint32_t v;
+    
+    CHECK(shring_create(&r, RING_NELEM, sizeof(uint32_t)) == 0);
+    
+    for(v = 0; v < RING_NELEM; v++)
+        CHECK(shring_push(&r, &v) == 0);
+    
+    atomic_set(&(r.hdr->head), RING_NELEM + 2);
+    
+    CHECK(shring_pop(&r, &v) == 0 && v == 2);
+    CHECK(atomic_read(&(r.hdr->tail)) == 3);
+    
+    shring_close(&r);
+}
+
+int main() {
+    check_wraparound();
+    check_overrun();
+    
+    return CHECK_DONE("shring");
+}
@@ -0,0 +1,229 @@
+#include "checkutils.h"
+#include "../daemon/lib/rts_taskset.h"
+#include <time.h>
+
+#define NTASK 40
+
+static struct rts_task task[NTASK];
+
+// task k has reservation id k + 1
+static void mktasks() {
+    for(int k = 0; k < NTASK; k++) {
+        rts_task_setup(&(task[k]), k + 1, CLOCK_MONOTONIC);
+        task[k].pluginid = -1;
+    }
+}
+
+// each task sits at the position the index gives for it
+static int index_consistent(struct rts_taskset* ts) {
+    for(uint32_t i = 0; i < ts->size; i++)
+        if(rts_taskset_search(ts, ts->tasks[i]->id) != ts->tasks[i])
+            return 0;
+    
+    return ts->tasks[ts->size] == NULL;
+}
+
+// the index grows past the first capacity of 16 and follows the swaps
+// of the removals: removing id 2 moves the last task, id 40, to position 1
+static void check_rsvid() {
+    struct rts_taskset ts;
+    struct rts_task* last;
+    
+    rts_taskset_init(&ts);
+    CHECK(rts_taskset_search(&ts, 1) == NULL);
+    
+    for(int k = 0; k < NTASK; k++)
+        CHECK(rts_taskset_add_top(&ts, &(task[k])) == 0);
+    
+    CHECK(ts.size == NTASK && ts.capacity == 64 && ts.index_size == 128);
+    CHECK(index_consistent(&ts));
+    CHECK(rts_taskset_search(&ts, NTASK + 1) == NULL);
+    CHECK(rts_taskset_search(&ts, 0) == NULL);
+    
+    CHECK(rts_taskset_remove_by_rsvid(&ts, 2) == &(task[1]));
+    CHECK(rts_taskset_get_i_task(&ts, 1) == &(task[NTASK - 1]));
+    CHECK(rts_taskset_search(&ts, 2) == NULL);
+    CHECK(rts_taskset_remove_by_rsvid(&ts, 2) == NULL);
+    
+    // every third task leaves, the holes of the index are filled back
+    for(int k = 0; k < NTASK; k += 3)
+        CHECK(rts_taskset_remove_by_rsvid(&ts, k + 1) == &(task[k]));
+    
+    CHECK(ts.size == NTASK - 1 - (NTASK + 2) / 3);
+    CHECK(index_consistent(&ts));
+    
+    for(int k = 0; k < NTASK; k++)
+        CHECK((rts_taskset_search(&ts, k + 1) == NULL) == (k % 3 == 0 || k == 1));
+    
+    // the top task leaves and the last one takes its place: id 1 left
+    // position 0 to id 39, the last at the time
+    last = rts_taskset_get_i_task(&ts, ts.size - 1);
+    CHECK(rts_taskset_remove_top(&ts) == &(task[NTASK - 2]));
+    CHECK(rts_taskset_get_top_task(&ts) == last);
+    CHECK(index_consistent(&ts));
+    
+    rts_taskset_destroy(&ts);
+}
+
+// a sort rebuilds the index on the new positions
+static void check_sort() {
+    struct rts_taskset ts;
+    
+    rts_taskset_init(&ts);
+    
+    for(int k = 0; k < NTASK; k++) {
+        rts_task_set_period(&(task[k]), (k * 7) % NTASK + 1);
+        rts_taskset_add_top(&ts, &(task[k]));
+    }
+    
+    rts_taskset_sort(&ts, PERIOD, ASC);
+    
+    for(uint32_t i = 0; i < ts.size; i++)
+        CHECK(ts.period[i] == i + 1);
+    
+    CHECK(index_consistent(&ts));
+    
+    rts_taskset_destroy(&ts);
+}
+
+// tasks of two parents, mixed with tasks of none: each drain removes the
+// tasks of its parent only, whatever the swaps move into their places
+static void check_ppid() {
+    struct rts_taskset ts;
+    struct rts_task* t;
+    int n100 = 0, n200 = 0;
+    
+    rts_taskset_init(&ts);
+    
+    for(int k = 0; k < NTASK; k++) {
+        task[k].ptid = k % 4 == 0 ? 100 : (k % 4 == 1 ? 200 : 0);
+        rts_taskset_add_top(&ts, &(task[k]));
+    }
+    
+    // a task added to the taskset goes at the head of its list
+    CHECK(rts_taskset_remove_by_ppid(&ts, 100) == &(task[NTASK - 4]));
+    CHECK(rts_taskset_remove_by_ppid(&ts, 0) == NULL);
+    CHECK(rts_taskset_remove_by_ppid(&ts, 300) == NULL);
+    
+    while((t = rts_taskset_remove_by_ppid(&ts, 100)) != NULL) {
+        CHECK(t->ptid == 100);
+        n100++;
+    }
+    
+    CHECK(n100 == NTASK / 4 - 1);
+    CHECK(ts.size == NTASK - NTASK / 4);
+    CHECK(index_consistent(&ts));
+    
+    while((t = rts_taskset_remove_by_ppid(&ts, 200)) != NULL) {
+        CHECK(t->ptid == 200);
+        n200++;
+    }
+    
+    CHECK(n200 == NTASK / 4);
+    CHECK(ts.size == NTASK / 2);
+    CHECK(index_consistent(&ts));
+    
+    for(uint32_t i = 0; i < ts.size; i++)
+        CHECK(ts.tasks[i]->ptid == 0);
+    
+    for(int k = 0; k < NTASK; k++)
+        task[k].ptid = 0;
+    
+    rts_taskset_destroy(&ts);
+}
+
+// the partition loop visits exactly the tasks of (pluginid, cpu)
+static int part_consistent(struct rts_taskset* ts, int pluginid, int cpu) {
+    int n = 0, m = 0;
+    
+    for(int i = rts_taskset_part_first(ts, pluginid, cpu); i != -1; i = rts_taskset_part_next(ts, i)) {
+        if(ts->pluginid[i] != pluginid || (int)ts->cpu[i] != cpu)
+            return 0;
+        
+        n++;
+    }
+    
+    for(uint32_t i = 0; i < ts->size; i++)
+        m += ts->tasks[i]->pluginid == pluginid && (int)ts->tasks[i]->cpu == cpu;
+    
+    return n == m;
+}
+
+static int parts_consistent(struct rts_taskset* ts) {
+    for(int p = 0; p < 2; p++)
+        for(int c = 0; c < 3; c++)
+            if(!part_consistent(ts, p, c))
+                return 0;
+    
+    return 1;
+}
+
+static int part_count(struct rts_taskset* ts, int pluginid, int cpu) {
+    int n = 0;
+    
+    for(int i = rts_taskset_part_first(ts, pluginid, cpu); i != -1; i = rts_taskset_part_next(ts, i))
+        n++;
+    
+    return n;
+}
+
+// two plugins on three cpus: task k in partition (k % 2, k / 2 % 3)
+static void check_partition() {
+    struct rts_taskset ts;
+    float percpu[3] = {0, 0, 0};
+    
+    rts_taskset_init(&ts);
+    
+    for(int k = 0; k < NTASK; k++) {
+        task[k].pluginid = k % 2;
+        task[k].cpu = k / 2 % 3;
+        task[k].util = 0.125;
+        rts_taskset_add_top(&ts, &(task[k]));
+    }
+    
+    // k = 0, 6, ..., 36 in (0, 0): 7 tasks, 6 in (1, 2)
+    CHECK(part_count(&ts, 0, 0) == 7 && part_count(&ts, 1, 2) == 6);
+    CHECK(part_count(&ts, 2, 0) == 0 && rts_taskset_part_first(&ts, 0, 3) == -1);
+    CHECK(parts_consistent(&ts));
+    
+    rts_taskset_sum_utils(&ts, 0, percpu, 3);
+    CHECK(percpu[0] == 0.875 && percpu[1] == 0.875 && percpu[2] == 0.75);
+    
+    // removals swap the last task of another partition in: k = 0, 30
+    // leave (0, 0), k = 25 leaves (1, 0) and k = 15 leaves (1, 1)
+    for(int k = 0; k < NTASK; k += 5)
+        CHECK(rts_taskset_remove_by_rsvid(&ts, k + 1) == &(task[k]));
+    
+    CHECK(parts_consistent(&ts));
+    CHECK(part_count(&ts, 0, 0) == 5);
+    CHECK(part_count(&ts, 1, 0) == 6 && part_count(&ts, 1, 1) == 6);
+    
+    // a task migrated to another cpu moves to its new partition
+    task[1].cpu = 1;
+    rts_taskset_update(&ts, &(task[1]));
+    CHECK(part_count(&ts, 1, 0) == 5 && part_count(&ts, 1, 1) == 7);
+    CHECK(parts_consistent(&ts));
+    
+    // out of its partition until it is updated
+    rts_taskset_part_leave(&ts, &(task[1]));
+    CHECK(part_count(&ts, 1, 1) == 6 && ts.pluginid[rts_taskset_part_first(&ts, 1, 1)] == 1);
+    rts_taskset_update(&ts, &(task[1]));
+    CHECK(part_count(&ts, 1, 1) == 7);
+    CHECK(parts_consistent(&ts));
+    
+    // a task no longer in the taskset is left alone
+    rts_taskset_part_leave(&ts, &(task[0]));
+    CHECK(part_count(&ts, 0, 0) == 5);
+    
+    rts_taskset_destroy(&ts);
+}
+
+int main() {
+    mktasks();
+    check_rsvid();
+    check_sort();
+    check_ppid();
+    check_partition();
+    
+    return CHECK_DONE("taskset");
+}
@@ -0,0 +1,29 @@
+/*
+ * File:   checkutils.h
+ * Author: gabrieleserra
+ *
+ * Created on October 17, 2026
+ */
+
+#ifndef CHECKUTILS_H
+#define CHECKUTILS_H
+
+#include <stdio.h>
+
+// deterministic checks of the components against hand-computed cases:
+// each program prints the checks that fail and returns their number
+
+static int check_failed;
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            printf("%s:%d: FAILED %s\n", __FILE__, __LINE__, #cond); \
+            check_failed++; \
+        } \
+    } while(0)
+
+#define CHECK_DONE(name) \
+    (printf("%s: %s\n", name, check_failed ? "FAILED" : "OK"), check_failed)
+
+#endif /* CHECKUTILS_H */
@@ -99,15 +99,14 @@ int main(int argc, char* argv[])
     
     for(int i = 0; i < nthread; i++) 
     {
-        if(rts_create_rsv(&rt_chn, &(rt_par[i]), &(rsv_id[i])) != RTS_GUARANTEED) {
-            printf("Can't get scheduling guarantees for thread num: %d!\n", i);
-            exit(EXIT_FAILURE);
-        }
-
         fill_params(&t_par, i, &(rt_par[i]));
         pthread_create(&(pt_id[i]), NULL, RT_task, (void*)&(t_par));
         lock_and_test(&m, &(t_ids[i]), 0);
-        rts_rsv_attach_thread(&rt_chn, rsv_id[i], t_ids[i]);        
+        
+        if(rts_create_rsv_attach(&rt_chn, &(rt_par[i]), t_ids[i], &(rsv_id[i])) != RTS_GUARANTEED) {
+            printf("Can't get scheduling guarantees for thread num: %d!\n", i);
+            exit(EXIT_FAILURE);
+        }
     }
     
     for (int i = 0; i < nthread; i++) 